@@ -0,0 +1,393 @@
+/**
+GestureBench.cpp
+
+Micro- and macro-benchmarks of the image kernels of both labs and of the hand-analysis stages.
+Every kernel runs on a synthetic frame (a skin-colored hand on a noisy background) and, when input= is given,
+on recorded frames, scaled to each of the benchmark resolutions. For each run the time of every iteration is kept,
+and the table and the JSON file report the mean, p50/p95/p99 and max latency and the throughput in megapixels per second.
+
+Switches (key=value):
+	sizes=480p,720p,1080p,4k	resolutions to run (default: all four)
+	iterations=N				timed iterations per kernel and resolution (default: 50)
+	warmup=N					untimed iterations first (default: 5)
+	input=PATH					recorded frames: a video file or a directory of images (optional)
+	only=NAME					run only the kernels whose name contains NAME
+	output=FILE					JSON results (default: gesture_bench.json)
+	threads=N band=H			as in the labs
+*/
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "BandExecutor.h"
+#include "HandAnalysis.h"
+#include "ImageKernels.h"
+#include "ImageTransforms.h"
+#include "Options.h"
+#include "SkinDetect.h"
+#include "TransformChain.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+One benchmark input: two consecutive frames, so the differencing kernels see motion
+*/
+struct BenchFrames {
+	string source;	// "synthetic" or "recorded"
+	Mat prev;
+	Mat curr;
+};
+
+/**
+Statistics of one kernel on one input
+*/
+struct BenchResult {
+	string kernel;
+	string source;
+	int width;
+	int height;
+	int iterations;
+	double mean;	// milliseconds
+	double p50;
+	double p95;
+	double p99;
+	double max;
+	double mpixPerSecond;
+};
+
+/**
+Function that draws a synthetic frame: a skin-colored open hand (palm and five fingers) on a noisy gray background
+@param size Size of the frame
+@param shift Horizontal offset of the hand in pixels, so two frames differ
+@param dst The destination BGR image
+*/
+void mySyntheticFrame(Size size, int shift, Mat& dst);
+
+/**
+Function that reads the first two frames of a video file or of a directory of images, returns false if there are fewer than two
+@param path The video file or directory
+@param frames Receives the two frames
+*/
+bool myRecordedFrames(const string& path, BenchFrames& frames);
+
+/**
+Function that returns the value below which a fraction q of the sorted samples fall
+@param sorted Samples in ascending order
+@param q Fraction in [0, 1]
+*/
+double myPercentile(const vector<double>& sorted, double q);
+
+/**
+Function that times a kernel and summarises the iterations
+@param kernel Name of the kernel
+@param frames The input the kernel runs on (for the source name and size)
+@param warmup Untimed iterations
+@param iterations Timed iterations
+@param body One iteration of the kernel
+*/
+BenchResult myRunKernel(const string& kernel, const BenchFrames& frames, int warmup, int iterations, const function<void()>& body);
+
+/**
+Function that writes the results as JSON, returns false if the file cannot be written
+@param path Name of the file
+@param results The results of every run
+*/
+bool myWriteJson(const string& path, const vector<BenchResult>& results);
+
+
+int main(int argc, char** argv)
+{
+	Options opts(argc, argv);
+	BandExecutor::configureShared(opts.getInt("threads", 0), opts.getInt("band", 0));
+	int iterations = max(1, opts.getInt("iterations", 50));
+	int warmup = max(0, opts.getInt("warmup", 5));
+	string only = opts.get("only");
+	string output = opts.get("output", "gesture_bench.json");
+
+	// resolutions by name
+	vector<pair<string, Size> > sizes;
+	string sizeList = opts.get("sizes", "480p,720p,1080p,4k");
+	stringstream sizeNames(sizeList);
+	string name;
+	while (getline(sizeNames, name, ','))
+	{
+		if (name == "480p") sizes.push_back(make_pair(name, Size(640, 480)));
+		else if (name == "720p") sizes.push_back(make_pair(name, Size(1280, 720)));
+		else if (name == "1080p") sizes.push_back(make_pair(name, Size(1920, 1080)));
+		else if (name == "4k") sizes.push_back(make_pair(name, Size(3840, 2160)));
+		else cout << "Unknown size " << name << ", skipped" << endl;
+	}
+
+	BenchFrames recorded;
+	bool haveRecorded = false;
+	if (opts.has("input"))
+	{
+		haveRecorded = myRecordedFrames(opts.get("input"), recorded);
+		if (!haveRecorded)
+		{
+			cout << "Cannot read two frames from " << opts.get("input") << ", running synthetic frames only" << endl;
+		}
+	}
+
+	cout << "skin kernel: " << skinDetectKernelName() << ", threads: " << BandExecutor::shared().threads() << endl;
+	cout << left << setw(24) << "kernel" << setw(11) << "source" << setw(11) << "size" << right << setw(10) << "mean" << setw(10) << "p50"
+		<< setw(10) << "p95" << setw(10) << "p99" << setw(10) << "max" << setw(12) << "MP/s" << endl;
+
+	vector<BenchResult> results;
+	for (size_t s = 0; s < sizes.size(); s++)
+	{
+		vector<BenchFrames> inputs(1);
+		inputs[0].source = "synthetic";
+		mySyntheticFrame(sizes[s].second, 0, inputs[0].prev);
+		mySyntheticFrame(sizes[s].second, sizes[s].second.width / 64, inputs[0].curr);
+		if (haveRecorded)
+		{
+			BenchFrames scaled;
+			scaled.source = "recorded";
+			resize(recorded.prev, scaled.prev, sizes[s].second);
+			resize(recorded.curr, scaled.curr, sizes[s].second);
+			inputs.push_back(scaled);
+		}
+
+		for (size_t in = 0; in < inputs.size(); in++)
+		{
+			BenchFrames& f = inputs[in];
+			Mat skin(f.curr.rows, f.curr.cols, CV_8UC1);
+			Mat gray, tint, thres, diff, energy(f.curr.rows, f.curr.cols, CV_8UC1);
+			vector<Mat> masks(3);
+			myFrameDifferencing(f.prev, f.curr, masks[0]);
+			myFrameDifferencing(f.curr, f.prev, masks[1]);
+			myFrameDifferencing(f.prev, f.prev, masks[2]);
+			// the same masks packed to one bit per pixel
+			BitMask skinBits, diffBits, energyBits;
+			vector<BitMask> bitMasks(3);
+			for (int m = 0; m < 3; m++)
+			{
+				bitMasks[m].fromMat(masks[m]);
+			}
+			SkinModel rgb;
+			myGrayScale(f.curr, gray);
+			mySkinDetect(f.curr, skin);
+
+			// the hand-analysis stages, on buffers kept across iterations as in the analysis thread
+			HandScratch scratch;
+			scratch.draw = false;
+			HandResult hand;
+			Mat analysed;
+			// the findContours path the blob extractor replaced, for comparison
+			Mat thresOutput;
+			vector<vector<Point> > contours;
+			vector<Vec4i> hierarchy;
+
+			vector<pair<string, function<void()> > > kernels;
+			kernels.push_back(make_pair(string("mySkinDetect"), function<void()>([&]() { mySkinDetect(f.curr, skin); })));
+			SkinModel ycrcb, hsv;
+			SkinModel::byName("ycrcb", ycrcb);
+			SkinModel::byName("hsv", hsv);
+			kernels.push_back(make_pair(string("mySkinDetect_ycrcb_lut"), function<void()>([&]() { mySkinDetect(f.curr, skin, ycrcb); })));
+			kernels.push_back(make_pair(string("mySkinDetect_hsv_lut"), function<void()>([&]() { mySkinDetect(f.curr, skin, hsv); })));
+			// the skin pass with the counts and the test of the "no hand" gate, the whole cost of a frame without a hand
+			SkinGate gate;
+			kernels.push_back(make_pair(string("mySkinDetect_gate"), function<void()>([&]() {
+				mySkinDetect(f.curr, skin, rgb, gate);
+				gate.anyCandidate();
+			})));
+			kernels.push_back(make_pair(string("myFrameDifferencing"), function<void()>([&]() { myFrameDifferencing(f.prev, f.curr, diff); })));
+			kernels.push_back(make_pair(string("myMotionEnergy"), function<void()>([&]() { myMotionEnergy(masks, energy); })));
+			kernels.push_back(make_pair(string("mySkinDetect_bits"), function<void()>([&]() { mySkinDetect(f.curr, skinBits, rgb); })));
+			kernels.push_back(make_pair(string("myFrameDifferencing_bits"), function<void()>([&]() { myFrameDifferencing(f.prev, f.curr, diffBits); })));
+			kernels.push_back(make_pair(string("myMotionEnergy_bits"), function<void()>([&]() { myMotionEnergy(bitMasks, energyBits); })));
+			kernels.push_back(make_pair(string("BitMask_erode"), function<void()>([&]() { bitMasks[0].erode(energyBits); })));
+			kernels.push_back(make_pair(string("myGrayScale"), function<void()>([&]() { myGrayScale(f.curr, gray); })));
+			kernels.push_back(make_pair(string("myTintImage"), function<void()>([&]() { myTintImage(f.curr, tint, 2); })));
+			kernels.push_back(make_pair(string("myThresholdImage"), function<void()>([&]() { myThresholdImage(gray, thres, 128); })));
+			// the same two transforms fused into one pass by the Lab1 batch mode
+			TransformChain grayThreshold;
+			string chainError;
+			grayThreshold.parse("gray,threshold:128", chainError);
+			kernels.push_back(make_pair(string("chain_gray_threshold"), function<void()>([&]() { grayThreshold.apply(f.curr, thres); })));
+			kernels.push_back(make_pair(string("contours_hull_defects"), function<void()>([&]() {
+				// threshold copies the mask first because findContours modifies its input
+				threshold(skin, thresOutput, 128, 255, 0);
+				findContours(thresOutput, contours, hierarchy, CV_RETR_TREE, CV_CHAIN_APPROX_SIMPLE);
+				double area = 0;
+				int largest = myLargestContour(contours, area);
+				if (largest >= 0)
+				{
+					myConvexHullDefects(contours[largest], scratch.hull);
+					myCountFingers(scratch.hull.defects, contours[largest], scratch.fingerPoints);
+				}
+			})));
+			kernels.push_back(make_pair(string("blobs_hull_defects"), function<void()>([&]() {
+				int largest = scratch.blobs.extract(skin, 128);
+				if (largest >= 0)
+				{
+					scratch.blobs.traceOuterContour(skin, largest, scratch.handContour);
+					myConvexHullDefects(scratch.handContour, scratch.hull);
+					myCountFingers(scratch.hull.defects, scratch.handContour, scratch.fingerPoints);
+				}
+			})));
+			kernels.push_back(make_pair(string("myAnalyzeFrame"), function<void()>([&]() {
+				myAnalyzeFrame(f.curr, analysed, scratch, hand);
+			})));
+			// coarse-to-fine at a fixed 1/2 and 1/4 working scale
+			HandScratch coarse2, coarse4;
+			coarse2.draw = coarse4.draw = false;
+			coarse2.scaler = ScaleController(0, 2);
+			coarse4.scaler = ScaleController(0, 4);
+			kernels.push_back(make_pair(string("myAnalyzeFrame_scale2"), function<void()>([&]() {
+				myAnalyzeFrame(f.curr, analysed, coarse2, hand);
+			})));
+			kernels.push_back(make_pair(string("myAnalyzeFrame_scale4"), function<void()>([&]() {
+				myAnalyzeFrame(f.curr, analysed, coarse4, hand);
+			})));
+
+			for (size_t k = 0; k < kernels.size(); k++)
+			{
+				if (!only.empty() && kernels[k].first.find(only) == string::npos)
+				{
+					continue;
+				}
+				BenchResult r = myRunKernel(kernels[k].first, f, warmup, iterations, kernels[k].second);
+				results.push_back(r);
+				cout << left << setw(24) << r.kernel << setw(11) << r.source << setw(11) << sizes[s].first << right << fixed << setprecision(3)
+					<< setw(10) << r.mean << setw(10) << r.p50 << setw(10) << r.p95 << setw(10) << r.p99 << setw(10) << r.max
+					<< setw(12) << setprecision(1) << r.mpixPerSecond << endl;
+			}
+		}
+	}
+
+	if (!myWriteJson(output, results))
+	{
+		cout << "Cannot write " << output << endl;
+		return -1;
+	}
+	cout << "Results written to " << output << endl;
+	return 0;
+}
+
+//Function that draws a synthetic frame
+void mySyntheticFrame(Size size, int shift, Mat& dst) {
+	dst.create(size, CV_8UC3);
+	// noisy background, darker than any skin tone, with the same seed every run
+	RNG rng(0x5eed);
+	rng.fill(dst, RNG::UNIFORM, Scalar(20, 30, 30), Scalar(90, 90, 90));
+
+	// the hand scales with the frame: palm in the middle, fingers above it
+	double unit = size.height / 480.0;
+	Scalar skinColor(120, 150, 210);
+	Point palm(size.width / 2 + shift, size.height * 5 / 8);
+	ellipse(dst, palm, Size(cvRound(70 * unit), cvRound(85 * unit)), 0, 0, 360, skinColor, -1);
+	for (int i = 0; i < 5; i++)
+	{
+		double angle = (-60 + 30 * i) * CV_PI / 180;
+		Point tip(palm.x + cvRound(sin(angle) * 170 * unit), palm.y - cvRound(cos(angle) * 170 * unit));
+		line(dst, palm, tip, skinColor, max(1, cvRound(22 * unit)));
+	}
+}
+
+//Function that reads the first two frames of a video file or of a directory of images
+bool myRecordedFrames(const string& path, BenchFrames& frames) {
+	frames.source = "recorded";
+	struct stat info;
+	if (stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR)
+	{
+		vector<String> files;
+		glob(path, files, false);
+		for (size_t i = 0; i < files.size() && frames.curr.empty(); i++)
+		{
+			Mat image = imread(files[i]);
+			if (image.empty())
+			{
+				continue;
+			}
+			(frames.prev.empty() ? frames.prev : frames.curr) = image;
+		}
+	}
+	else
+	{
+		VideoCapture cap(path);
+		if (cap.isOpened())
+		{
+			cap.read(frames.prev);
+			cap.read(frames.curr);
+		}
+	}
+	return !frames.prev.empty() && !frames.curr.empty();
+}
+
+//Function that returns the value below which a fraction q of the sorted samples fall
+double myPercentile(const vector<double>& sorted, double q) {
+	if (sorted.empty())
+	{
+		return 0;
+	}
+	size_t rank = (size_t)ceil(q * sorted.size());
+	return sorted[min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+//Function that times a kernel and summarises the iterations
+BenchResult myRunKernel(const string& kernel, const BenchFrames& frames, int warmup, int iterations, const function<void()>& body) {
+	for (int i = 0; i < warmup; i++)
+	{
+		body();
+	}
+	vector<double> samples(iterations);
+	double total = 0;
+	for (int i = 0; i < iterations; i++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		body();
+		samples[i] = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		total += samples[i];
+	}
+	sort(samples.begin(), samples.end());
+
+	BenchResult r;
+	r.kernel = kernel;
+	r.source = frames.source;
+	r.width = frames.curr.cols;
+	r.height = frames.curr.rows;
+	r.iterations = iterations;
+	r.mean = total / iterations;
+	r.p50 = myPercentile(samples, 0.50);
+	r.p95 = myPercentile(samples, 0.95);
+	r.p99 = myPercentile(samples, 0.99);
+	r.max = samples.back();
+	r.mpixPerSecond = r.mean > 0 ? (double)r.width * r.height / 1e6 / (r.mean / 1000.0) : 0;
+	return r;
+}
+
+//Function that writes the results as JSON
+bool myWriteJson(const string& path, const vector<BenchResult>& results) {
+	ofstream out(path.c_str(), ios::out | ios::trunc);
+	if (!out.is_open())
+	{
+		return false;
+	}
+	out << fixed << setprecision(4);
+	out << "{\"skin_kernel\":\"" << skinDetectKernelName() << "\",\"threads\":" << BandExecutor::shared().threads() << ",\"results\":[";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+		out << (i ? "," : "") << "\n  {\"kernel\":\"" << r.kernel << "\",\"source\":\"" << r.source << "\",\"width\":" << r.width
+			<< ",\"height\":" << r.height << ",\"iterations\":" << r.iterations << ",\"mean_ms\":" << r.mean << ",\"p50_ms\":" << r.p50
+			<< ",\"p95_ms\":" << r.p95 << ",\"p99_ms\":" << r.p99 << ",\"max_ms\":" << r.max << ",\"mpix_per_s\":" << r.mpixPerSecond << '}';
+	}
+	out << "\n]}\n";
+	return out.good();
+}
@@ -0,0 +1,148 @@
+#include "BandExecutor.h"
+
+#include <algorithm>
+
+// true on threads that are currently inside a band, so nested run() calls do not wait on themselves
+static thread_local bool t_inBand = false;
+// true on threads that asked for serial runs with setSerialOnThisThread
+static thread_local bool t_serial = false;
+
+BandExecutor::BandExecutor(int threads, int bandHeight)
+	: m_threads(threads), m_bandHeight(std::max(0, bandHeight)), m_generation(0), m_active(0), m_stop(false),
+	m_function(nullptr), m_body(nullptr), m_rows(0), m_band(1), m_next(0)
+{
+	if (m_threads <= 0) {
+		m_threads = (int)std::thread::hardware_concurrency();
+	}
+	if (m_threads <= 0) {
+		m_threads = 1;
+	}
+	//the calling thread is one of the workers
+	for (int i = 1; i < m_threads; i++) {
+		m_workers.push_back(std::thread(&BandExecutor::workerLoop, this));
+	}
+}
+
+BandExecutor::~BandExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+}
+
+void BandExecutor::runBands(int rows, BandFunction function, const void* body)
+{
+	if (rows <= 0) {
+		return;
+	}
+	//by default give every thread about four bands so uneven rows still balance out
+	int band = m_bandHeight > 0 ? m_bandHeight : std::max(8, rows / (m_threads * 4));
+	if (m_workers.empty() || t_inBand || t_serial || band >= rows) {
+		function(body, 0, rows);
+		return;
+	}
+
+	//busy with another thread's job: waiting would serialize the two callers, so this one runs alone
+	std::unique_lock<std::mutex> runLock(m_runLock, std::try_to_lock);
+	if (!runLock.owns_lock()) {
+		function(body, 0, rows);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_function = function;
+		m_body = body;
+		m_rows = rows;
+		m_band = band;
+		m_next.store(0);
+		m_active = (int)m_workers.size();
+		m_error = nullptr;
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	drain();
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lk(m_lock);
+		m_done.wait(lk, [this] { return m_active == 0; });
+		m_function = nullptr;
+		m_body = nullptr;
+		error = m_error;
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+//Takes bands off the shared counter until none are left
+void BandExecutor::drain()
+{
+	t_inBand = true;
+	try {
+		for (;;) {
+			int first = m_next.fetch_add(m_band);
+			if (first >= m_rows) {
+				break;
+			}
+			m_function(m_body, first, std::min(first + m_band, m_rows));
+		}
+	}
+	catch (...) {
+		//keep the first error for run() to rethrow and let the other threads finish the job
+		std::lock_guard<std::mutex> lk(m_lock);
+		if (!m_error) {
+			m_error = std::current_exception();
+		}
+		m_next.store(m_rows);
+	}
+	t_inBand = false;
+}
+
+void BandExecutor::workerLoop()
+{
+	unsigned seen = 0;
+	std::unique_lock<std::mutex> lk(m_lock);
+	for (;;) {
+		m_wake.wait(lk, [&] { return m_stop || m_generation != seen; });
+		if (m_stop) {
+			return;
+		}
+		seen = m_generation;
+		lk.unlock();
+		drain();
+		lk.lock();
+		if (--m_active == 0) {
+			m_done.notify_one();
+		}
+	}
+}
+
+static std::mutex g_sharedLock;
+static std::unique_ptr<BandExecutor> g_shared;
+
+BandExecutor& BandExecutor::shared()
+{
+	std::lock_guard<std::mutex> lk(g_sharedLock);
+	if (!g_shared) {
+		g_shared.reset(new BandExecutor());
+	}
+	return *g_shared;
+}
+
+void BandExecutor::configureShared(int threads, int bandHeight)
+{
+	std::lock_guard<std::mutex> lk(g_sharedLock);
+	g_shared.reset(new BandExecutor(threads, bandHeight));
+}
+
+void BandExecutor::setSerialOnThisThread(bool serial)
+{
+	t_serial = serial;
+}
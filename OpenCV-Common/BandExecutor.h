@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+BandExecutor.h
+
+Persistent thread pool that runs a per-pixel kernel over horizontal bands of rows.
+The worker threads are started once and sleep between calls, so nothing is created per frame.
+Shared by the Lab1 and Lab2 kernels.
+*/
+class BandExecutor {
+public:
+	/**
+	Creates the executor and starts its worker threads
+	@param threads Number of threads that work on each call, including the calling thread (0 = one per hardware core)
+	@param bandHeight Number of rows handed to a thread at a time (0 = derived from the image height and thread count)
+	*/
+	explicit BandExecutor(int threads = 0, int bandHeight = 0);
+
+	/**
+	Stops and joins the worker threads
+	*/
+	~BandExecutor();
+
+	/**
+	Splits [0, rows) into bands and calls body(firstRow, endRow) for each of them, returns when every band is done.
+	The calling thread works on bands too. A call made from inside a band, or while another thread's call holds the
+	executor, runs serially on the calling thread instead of waiting for it.
+	The body is only referenced, never copied into a std::function, so a call does not allocate whatever the lambda captures
+	@param rows Number of rows to cover
+	@param body Function object that processes the rows [firstRow, endRow)
+	*/
+	template <class Body>
+	void run(int rows, const Body& body) { runBands(rows, &callBody<Body>, &body); }
+
+	/**
+	Function that returns the number of threads used per call, including the caller
+	*/
+	int threads() const { return m_threads; }
+
+	/**
+	Function that returns the configured band height (0 = automatic)
+	*/
+	int bandHeight() const { return m_bandHeight; }
+
+	/**
+	Function that returns the process-wide executor used by the image kernels, created with default settings on first use
+	*/
+	static BandExecutor& shared();
+
+	/**
+	Replaces the process-wide executor. Must be called before any kernel runs (e.g. right after parsing threads=N)
+	@param threads Number of threads (0 = one per hardware core)
+	@param bandHeight Band height in rows (0 = automatic)
+	*/
+	static void configureShared(int threads, int bandHeight);
+
+	/**
+	Makes the run() calls of the calling thread process every band themselves, for threads of another pool
+	(e.g. WorkStealingPool) that already keeps the cores busy
+	@param serial true to run serially on this thread, false to use the executor again
+	*/
+	static void setSerialOnThisThread(bool serial);
+
+private:
+	BandExecutor(const BandExecutor&);
+	BandExecutor& operator=(const BandExecutor&);
+
+	//type-erased band function: calls the Body at body on the rows [first, end)
+	typedef void(*BandFunction)(const void* body, int first, int end);
+
+	template <class Body>
+	static void callBody(const void* body, int first, int end) { (*static_cast<const Body*>(body))(first, end); }
+
+	void runBands(int rows, BandFunction function, const void* body);
+	void workerLoop();
+	void drain();
+
+	int m_threads;
+	int m_bandHeight;
+	std::vector<std::thread> m_workers;
+
+	// one job at a time; held by run() for its whole duration (other callers run their bands themselves)
+	std::mutex m_runLock;
+
+	// protects everything below except m_next
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	unsigned m_generation;
+	int m_active;
+	bool m_stop;
+	std::exception_ptr m_error;
+
+	// the current job
+	BandFunction m_function;
+	const void* m_body;
+	int m_rows;
+	int m_band;
+	std::atomic<int> m_next;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+BoundedRing.h
+
+Fixed-capacity lock-free ring used to hand frames from one pipeline stage to the next.
+One thread pushes and one thread pops. The pushing thread may also evict the oldest entry
+(pushDropOldest), so each slot carries a sequence number and positions are claimed with a
+compare-and-swap (bounded queue after D. Vyukov), which keeps eviction safe against a concurrent pop.
+*/
+template<typename T>
+class BoundedRing {
+public:
+	/**
+	Creates the ring; all slots are allocated here and reused afterwards
+	@param capacity Maximum number of queued entries (rounded up to a power of two, at least 2)
+	*/
+	explicit BoundedRing(size_t capacity) : m_slots(roundUp(capacity)), m_mask(m_slots.size() - 1), m_head(0), m_tail(0)
+	{
+		for (size_t i = 0; i < m_slots.size(); i++) {
+			m_slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	Function that appends an entry, returns false (and leaves value untouched) when the ring is full
+	@param value Entry to move into the ring; on success it receives the stale contents of the slot, which the caller may reuse
+	*/
+	bool tryPush(T& value)
+	{
+		size_t pos = m_head.load(std::memory_order_relaxed);
+		Slot& slot = m_slots[pos & m_mask];
+		if (slot.seq.load(std::memory_order_acquire) != pos) {
+			return false;
+		}
+		m_head.store(pos + 1, std::memory_order_relaxed);
+		std::swap(slot.value, value);
+		slot.seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	Function that appends an entry, evicting the oldest ones while the ring is full.
+	Only the pushing thread may call it; evicted entries are recycled, not freed
+	@param value Entry to move into the ring
+	@return Number of entries that were evicted
+	*/
+	int pushDropOldest(T& value)
+	{
+		int dropped = 0;
+		while (!tryPush(value)) {
+			//the evicted entry is swapped into m_spare, whose old contents stay in the ring for reuse
+			if (tryPop(m_spare)) {
+				dropped++;
+			}
+		}
+		return dropped;
+	}
+
+	/**
+	Function that removes the oldest entry, returns false when the ring is empty
+	@param value Receives the entry; its previous contents are left in the slot for reuse
+	*/
+	bool tryPop(T& value)
+	{
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		for (;;) {
+			Slot& slot = m_slots[pos & m_mask];
+			size_t seq = slot.seq.load(std::memory_order_acquire);
+			if (seq < pos + 1) {
+				return false;
+			}
+			if (seq == pos + 1) {
+				if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					std::swap(slot.value, value);
+					slot.seq.store(pos + m_slots.size(), std::memory_order_release);
+					return true;
+				}
+			}
+			else {
+				pos = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	Function that returns the number of queued entries (a snapshot, may be stale by the time it is used)
+	*/
+	size_t size() const
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		return head > tail ? head - tail : 0;
+	}
+
+	/**
+	Function that returns the maximum number of queued entries
+	*/
+	size_t capacity() const { return m_slots.size(); }
+
+private:
+	struct Slot {
+		std::atomic<size_t> seq;
+		T value;
+		Slot() : seq(0) {}
+	};
+
+	static size_t roundUp(size_t n)
+	{
+		size_t c = 2;
+		while (c < n) {
+			c <<= 1;
+		}
+		return c;
+	}
+
+	std::vector<Slot> m_slots;
+	const size_t m_mask;
+	std::atomic<size_t> m_head;
+	std::atomic<size_t> m_tail;
+
+	// receives evicted entries; touched by the pushing thread only
+	T m_spare;
+};
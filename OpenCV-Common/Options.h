@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+
+/**
+Options.h
+
+Command line switches of the form key=value (e.g. threads=4 band=32).
+Arguments without '=' are stored with an empty value so they can be tested with has().
+*/
+class Options {
+public:
+	/**
+	Parses the program arguments
+	@param argc Number of arguments, as passed to main
+	@param argv Argument strings, as passed to main; argv[0] is skipped
+	*/
+	Options(int argc, char** argv) {
+		for (int i = 1; i < argc; i++) {
+			add(argv[i]);
+		}
+	}
+
+	/**
+	Parses switches given as one string, separated by white space (e.g. "skin=ycrcb track=1")
+	@param line The switches
+	*/
+	explicit Options(const std::string& line) {
+		std::istringstream in(line);
+		std::string arg;
+		while (in >> arg) {
+			add(arg);
+		}
+	}
+
+	/**
+	Function that tells whether a switch was given
+	@param key Name of the switch
+	*/
+	bool has(const std::string& key) const {
+		return m_values.find(key) != m_values.end();
+	}
+
+	/**
+	Function that returns the value of a switch as a string
+	@param key Name of the switch
+	@param def Value returned when the switch was not given
+	*/
+	std::string get(const std::string& key, const std::string& def = "") const {
+		std::map<std::string, std::string>::const_iterator it = m_values.find(key);
+		return it == m_values.end() ? def : it->second;
+	}
+
+	/**
+	Function that returns the value of a switch as an integer
+	@param key Name of the switch
+	@param def Value returned when the switch was not given or is empty
+	*/
+	int getInt(const std::string& key, int def) const {
+		std::string v = get(key);
+		return v.empty() ? def : std::atoi(v.c_str());
+	}
+
+	/**
+	Function that returns the value of a switch as a floating point number
+	@param key Name of the switch
+	@param def Value returned when the switch was not given or is empty
+	*/
+	double getDouble(const std::string& key, double def) const {
+		std::string v = get(key);
+		return v.empty() ? def : std::atof(v.c_str());
+	}
+
+private:
+	//stores one key=value argument
+	void add(const std::string& arg) {
+		size_t eq = arg.find('=');
+		if (eq == std::string::npos) {
+			m_values[arg] = "";
+		}
+		else {
+			m_values[arg.substr(0, eq)] = arg.substr(eq + 1);
+		}
+	}
+
+	std::map<std::string, std::string> m_values;
+};
@@ -0,0 +1,87 @@
+#include "WorkStealingPool.h"
+
+// the pool and queue of the calling thread when it is a worker, so tasks submitted from a task stay local
+static thread_local WorkStealingPool* t_pool = nullptr;
+static thread_local int t_worker = -1;
+
+WorkStealingPool::WorkStealingPool(int threads)
+	: m_nextQueue(0), m_queued(0), m_steals(0), m_stop(false)
+{
+	if (threads <= 0) {
+		threads = (int)std::thread::hardware_concurrency();
+	}
+	if (threads <= 0) {
+		threads = 1;
+	}
+	for (int i = 0; i < threads; i++) {
+		m_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	}
+	for (int i = 0; i < threads; i++) {
+		m_threads.push_back(std::thread(&WorkStealingPool::workerLoop, this, i));
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_idleLock);
+		m_stop = true;
+	}
+	m_idle.notify_all();
+	for (size_t i = 0; i < m_threads.size(); i++) {
+		m_threads[i].join();
+	}
+}
+
+void WorkStealingPool::submit(Task task)
+{
+	int q = t_pool == this ? t_worker : (int)(m_nextQueue++ % m_queues.size());
+	{
+		std::lock_guard<std::mutex> lk(m_queues[q]->lock);
+		m_queues[q]->tasks.push_back(std::move(task));
+	}
+	m_queued++;
+	//taking the idle lock orders the count against a worker that is about to sleep, so the wake-up is not lost
+	{
+		std::lock_guard<std::mutex> lk(m_idleLock);
+	}
+	m_idle.notify_one();
+}
+
+bool WorkStealingPool::take(int id, Task& task)
+{
+	int n = (int)m_queues.size();
+	for (int k = 0; k < n; k++) {
+		Queue& q = *m_queues[(id + k) % n];
+		std::lock_guard<std::mutex> lk(q.lock);
+		if (!q.tasks.empty()) {
+			task = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			m_queued--;
+			if (k > 0) {
+				m_steals++;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::workerLoop(int id)
+{
+	t_pool = this;
+	t_worker = id;
+	Task task;
+	for (;;) {
+		if (take(id, task)) {
+			task();
+			task = nullptr;
+			continue;
+		}
+		std::unique_lock<std::mutex> lk(m_idleLock);
+		m_idle.wait(lk, [this] { return m_stop || m_queued > 0; });
+		if (m_stop) {
+			return;
+		}
+	}
+}
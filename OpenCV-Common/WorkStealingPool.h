@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+WorkStealingPool.h
+
+Persistent thread pool for independent tasks, such as the frames of many camera streams.
+Every worker has its own task queue, so workers do not contend on a single lock; a worker whose queue is empty
+steals from the queues of the others, so an uneven mix of heavy and light tasks still keeps every core busy.
+Tasks are taken oldest first, both from the own queue and when stealing: a task that resubmits itself goes behind
+the tasks already waiting, which gives round-robin order between the producers.
+*/
+class WorkStealingPool {
+public:
+	typedef std::function<void()> Task;
+
+	/**
+	Creates the pool and starts its worker threads
+	@param threads Number of worker threads (0 = one per hardware core)
+	*/
+	explicit WorkStealingPool(int threads = 0);
+
+	/**
+	Stops and joins the worker threads; tasks that have not started are dropped
+	*/
+	~WorkStealingPool();
+
+	/**
+	Queues a task. From a worker thread it goes to that worker's queue, otherwise the queues are used in turn.
+	Tasks must not throw
+	@param task Function to run on one of the workers
+	*/
+	void submit(Task task);
+
+	/**
+	Function that returns the number of worker threads
+	*/
+	int threads() const { return (int)m_threads.size(); }
+
+	/**
+	Function that returns how many tasks were taken from another worker's queue so far
+	*/
+	unsigned long long steals() const { return m_steals; }
+
+private:
+	WorkStealingPool(const WorkStealingPool&);
+	WorkStealingPool& operator=(const WorkStealingPool&);
+
+	struct Queue {
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	void workerLoop(int id);
+	//takes the oldest task of the worker's own queue, or else of another queue
+	bool take(int id, Task& task);
+
+	std::vector<std::unique_ptr<Queue> > m_queues;
+	std::vector<std::thread> m_threads;
+	std::atomic<unsigned> m_nextQueue;
+	std::atomic<int> m_queued;
+	std::atomic<unsigned long long> m_steals;
+
+	// idle workers sleep here until a task is queued
+	std::mutex m_idleLock;
+	std::condition_variable m_idle;
+	bool m_stop;
+};
@@ -0,0 +1,131 @@
+#include "BatchTransform.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "BandExecutor.h"
+#include "WorkStealingPool.h"
+
+using namespace cv;
+using namespace std;
+
+//Function that expands a comma-separated list of inputs into image files
+void myListImages(const string& inputs, vector<string>& files) {
+	stringstream list(inputs);
+	string item;
+	while (getline(list, item, ','))
+	{
+		struct stat info;
+		if (item.empty())
+		{
+			continue;
+		}
+		if (item[0] == '@')
+		{
+			// a list file: one path per line
+			ifstream in(item.c_str() + 1);
+			string line;
+			while (getline(in, line))
+			{
+				if (!line.empty() && line[line.size() - 1] == '\r')
+				{
+					line.erase(line.size() - 1);
+				}
+				if (!line.empty())
+				{
+					files.push_back(line);
+				}
+			}
+		}
+		else if (stat(item.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR)
+		{
+			vector<String> names;
+			glob(item, names, false);
+			files.insert(files.end(), names.begin(), names.end());
+		}
+		else
+		{
+			files.push_back(item);
+		}
+	}
+}
+
+//Function that returns the output name of an image
+string myOutputName(const string& file, const string& outputDir, const string& extension) {
+	size_t slash = file.find_last_of("/\\");
+	string name = slash == string::npos ? file : file.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+	if (!extension.empty())
+	{
+		name = name.substr(0, dot) + extension;
+	}
+	if (outputDir.empty())
+	{
+		return name;
+	}
+	char last = outputDir[outputDir.size() - 1];
+	return outputDir + (last == '/' || last == '\\' ? "" : "/") + name;
+}
+
+//Function that runs a chain on every file
+BatchStats myRunBatch(const vector<string>& files, const TransformChain& chain, const string& outputDir,
+	const string& extension, int threads, int inflight) {
+	BatchStats stats;
+	// the images on their way through the pool; the submitting thread waits while there are limit of them.
+	// Declared before the pool, whose workers use them until it is destroyed
+	mutex lock;
+	condition_variable done;
+	int running = 0;
+	WorkStealingPool pool(threads);
+	int limit = inflight > 0 ? inflight : 2 * pool.threads();
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		{
+			unique_lock<mutex> guard(lock);
+			done.wait(guard, [&]() { return running < limit; });
+			running++;
+		}
+		const string& file = files[i];
+		pool.submit([&, file]() {
+			// the images keep all the cores busy: the chain runs on this worker only
+			BandExecutor::setSerialOnThisThread(true);
+			Mat image = imread(file, CV_LOAD_IMAGE_COLOR);
+			bool ok = !image.empty();
+			Mat result;
+			if (ok)
+			{
+				chain.apply(image, result);
+				ok = imwrite(myOutputName(file, outputDir, extension), result);
+			}
+			unique_lock<mutex> guard(lock);
+			if (ok)
+			{
+				stats.images++;
+				stats.megapixels += image.rows * (double)image.cols / 1e6;
+			}
+			else
+			{
+				cout << "Cannot transform " << file << endl;
+				stats.failed++;
+			}
+			running--;
+			done.notify_all();
+		});
+	}
+	{
+		unique_lock<mutex> guard(lock);
+		done.wait(guard, [&]() { return running == 0; });
+	}
+	stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return stats;
+}
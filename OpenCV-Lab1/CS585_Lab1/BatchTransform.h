@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "TransformChain.h"
+
+/**
+BatchTransform.h
+
+Batch mode of the lab: a transform chain applied to many images. Each image is one task on a work-stealing pool
+that decodes it, runs the chain (in one pass, see TransformChain.h) and encodes the result, so while one worker decodes
+an image another one runs the chain on the next and a third encodes the one before: the three stages overlap across
+images. At most `inflight` images are decoded and not yet written at any time, which bounds the memory used.
+*/
+
+/**
+Counters of a batch run
+*/
+struct BatchStats {
+	unsigned long long images;		// images written
+	unsigned long long failed;		// images that could not be read or written
+	double megapixels;				// pixels of the images written, in millions
+	double seconds;					// wall time of the run
+
+	BatchStats() : images(0), failed(0), megapixels(0), seconds(0) {}
+};
+
+/**
+Function that expands a comma-separated list of inputs into image files: a directory gives its files in name order,
+@FILE gives the paths listed in FILE (one per line) and anything else is taken as an image file
+@param inputs The list
+@param files Receives the files
+*/
+void myListImages(const std::string& inputs, std::vector<std::string>& files);
+
+/**
+Function that returns the output name of an image: its file name in the output directory, with the extension replaced if one is given
+@param file The input file
+@param outputDir The output directory (empty for the current directory)
+@param extension The new extension with its dot (".png"), or empty to keep the one of the input
+*/
+std::string myOutputName(const std::string& file, const std::string& outputDir, const std::string& extension);
+
+/**
+Function that runs a chain on every file, returns the counters
+@param files The input images
+@param chain The transforms
+@param outputDir The output directory (must exist)
+@param extension Extension of the outputs, or empty to keep the input one
+@param threads Number of worker threads (0 = one per hardware core)
+@param inflight Most images decoded and not yet written at a time (0 = twice the number of threads)
+*/
+BatchStats myRunBatch(const std::vector<std::string>& files, const TransformChain& chain, const std::string& outputDir,
+	const std::string& extension, int threads, int inflight);
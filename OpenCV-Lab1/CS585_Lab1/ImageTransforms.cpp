@@ -0,0 +1,66 @@
+#include "ImageTransforms.h"
+
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "BandExecutor.h"
+
+using namespace cv;
+
+void grayScaleRow(const unsigned char* bgr, unsigned char* gray, int width)
+{
+	for (int j = 0; j < width; j++, bgr += 3){
+		gray[j] = (unsigned char)((bgr[0] * 1868 + bgr[1] * 9617 + bgr[2] * 4899 + (1 << 13)) >> 14);
+	}
+}
+
+void tintRow(const unsigned char* bgr, unsigned char* out, int width, int channel)
+{
+	for (int j = 0; j < width; j++, bgr += 3, out += 3){
+		//For each pixel, keep the channel passed in the argument of the function and suppress the other two
+		unsigned char kept = bgr[channel];
+		out[0] = 0;
+		out[1] = 0;
+		out[2] = 0;
+		out[channel] = kept;
+	}
+}
+
+void thresholdRow(const unsigned char* gray, unsigned char* out, int width, int threshold)
+{
+	for (int j = 0; j < width; j++){
+		//For each pixel, assign intensity value of 0 if below threshold, else assign intensity value of 255
+		out[j] = gray[j] < threshold ? 0 : 255;
+	}
+}
+
+//Creates a grayscale image from a color image.
+void myGrayScale(Mat& src, Mat& dst) {
+	//Different algorithms for converting color to grayscale: http://www.johndcook.com/blog/2009/08/24/algorithms-convert-color-grayscale/
+	dst.create(src.rows, src.cols, CV_8UC1);
+	//Each band of rows is converted on its own thread. The destination band is a view into dst with the right size and type,
+	//so cvtColor writes straight into it
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		Mat dstBand = dst.rowRange(first, end);
+		cvtColor(src.rowRange(first, end), dstBand, CV_BGR2GRAY); //cvtColor documentation: http://docs.opencv.org/modules/imgproc/doc/miscellaneous_transformations.html
+	});
+}
+
+//Creates a tinted image from a color image.
+void myTintImage(Mat& src, Mat& dst, int channel) {
+	dst.create(src.rows, src.cols, src.type());
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			tintRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), src.cols, channel);
+		}
+	});
+}
+
+//Creates a thresholded image from a grayscale image.
+void myThresholdImage(Mat& src, Mat& dst, int threshold) {
+	dst.create(src.rows, src.cols, CV_8UC1);
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			thresholdRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), src.cols, threshold);
+		}
+	});
+}
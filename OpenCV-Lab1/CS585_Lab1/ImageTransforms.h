@@ -0,0 +1,66 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+/**
+ImageTransforms.h
+
+The per-pixel transforms of the lab, split out of Source.cpp so other programs (the benchmarks, the batch tool) can link them.
+Each one runs its rows in bands on the shared BandExecutor. The row functions below do the work of one row, so a chain of
+transforms can be run row by row (see TransformChain.h).
+*/
+
+/**
+Converts one row of BGR pixels to gray, with the fixed-point weights of cvtColor(CV_BGR2GRAY) for 8 bit images
+
+@param bgr Pointer to the first pixel of the source row, 3 bytes per pixel
+@param gray Pointer to the first pixel of the destination row, 1 byte per pixel
+@param width Number of pixels in the row
+*/
+void grayScaleRow(const unsigned char* bgr, unsigned char* gray, int width);
+
+/**
+Tints one row of BGR pixels: the channel is kept and the other two are set to 0
+
+@param bgr Pointer to the first pixel of the source row, 3 bytes per pixel
+@param out Pointer to the first pixel of the destination row, 3 bytes per pixel (may be the source)
+@param width Number of pixels in the row
+@param channel The channel that is kept (0: blue, 1: green, 2: red)
+*/
+void tintRow(const unsigned char* bgr, unsigned char* out, int width, int channel);
+
+/**
+Thresholds one row of gray pixels: 0 below the threshold, 255 from it up
+
+@param gray Pointer to the first pixel of the source row
+@param out Pointer to the first pixel of the destination row (may be the source)
+@param width Number of pixels in the row
+@param threshold The threshold intensity
+*/
+void thresholdRow(const unsigned char* gray, unsigned char* out, int width, int threshold);
+
+/**
+Creates a grayscale image from a color image.
+
+@param src The source color image
+@param dst The destination grayscale image
+*/
+void myGrayScale(cv::Mat& src, cv::Mat& dst);
+
+/**
+Creates a tinted image from a color image.
+
+@param src The source color image
+@param dst The destination tinted image
+@param channel The channel specifies the tint
+*/
+void myTintImage(cv::Mat& src, cv::Mat& dst, int channel);
+
+/**
+Creates a thresholded image from a grayscale image.
+
+@param src The source color image
+@param dst The destination tinted image
+@param threshold The specified threshold intensity
+*/
+void myThresholdImage(cv::Mat& src, cv::Mat& dst, int threshold);
@@ -34,45 +34,41 @@ c) Basic thresholding
 
 #include <iostream>
 #include <string>
+#include <vector>
+
+//persistent thread pool that splits the per-pixel loops into bands of rows, and the key=value command line switches
+#include "BandExecutor.h"
+#include "Options.h"
 
 using namespace cv;
 using namespace std;
 
 // These are the function signatures (declarations) for some functions we will use 
-// in today's lab. The function bodies (definitions) are underneath the 
-// main() function. In C++, functions must be declared or defined in the file before you attempt to use them.
-// To help keep your file organized, you can provide a declaration (just the function signature) 
-// before you provide the body of the function. The arguments and return value of the declaration 
-// and definition must match exactly.
-
-/**
-Creates a grayscale image from a color image.
-
-@param src The source color image
-@param dst The destination grayscale image
-*/
-void myGrayScale(Mat& src, Mat& dst);
+// in today's lab. They are in ImageTransforms.h and the function bodies (definitions) in ImageTransforms.cpp.
+// In C++, functions must be declared or defined in the file before you attempt to use them;
+// including the header provides the declarations.
+#include "ImageTransforms.h"
+#include "BatchTransform.h"
 
 /**
-Creates a tinted image from a color image.
+Runs the batch mode: a chain of transforms on every input image, returns the exit code
 
-@param src The source color image
-@param dst The destination tinted image
-@param channel The channel specifies the tint
+@param opts The command line switches
 */
-void myTintImage(Mat& src, Mat& dst, int channel);
+int myBatchMain(const Options& opts);
 
-/**
-Creates a thresholded image from a grayscale image.
+int main(int argc, char** argv)
+{
+	//threads=N caps the number of cores used by the pixel loops, band=H sets the number of rows per band
+	Options opts(argc, argv);
+	BandExecutor::configureShared(opts.getInt("threads", 0), opts.getInt("band", 0));
 
-@param src The source color image
-@param dst The destination tinted image
-@param threshold The specified threshold intensity
-*/
-void myThresholdImage(Mat& src, Mat& dst, int threshold);
+	//input=DIR,FILE,@LIST switches to the batch mode, without windows (see BatchTransform.h)
+	if (opts.has("input"))
+	{
+		return myBatchMain(opts);
+	}
 
-int main()
-{
 	//----------------
 	//a) Reading an image from a file, displaying the image, writing an image to a file
 	//----------------
@@ -173,48 +169,32 @@ int main()
 	return 0;
 }
 
-//Creates a grayscale image from a color image.
-void myGrayScale(Mat& src, Mat& dst) {
-	//Different algorithms for converting color to grayscale: http://www.johndcook.com/blog/2009/08/24/algorithms-convert-color-grayscale/
-	dst = Mat::zeros(src.rows, src.cols, CV_8UC1); //Returns a zero array of same size as src mat, and of type CV_8UC1
-	for (int i = 0; i < src.rows; i++){
-		for (int j = 0; j < src.cols; j++){
-			//For each pixel, compute the average intensity of the 3 color channels
-			Vec3b intensity = src.at<Vec3b>(i,j); //Vec3b is a vector of 3 uchar (unsigned character)
-			int avg = (intensity[0] + intensity[1] + intensity[2])/3;
-			dst.at<uchar>(i,j) = avg;
-		}
-	} 
-	cvtColor(src, dst, CV_BGR2GRAY); //cvtColor documentation: http://docs.opencv.org/modules/imgproc/doc/miscellaneous_transformations.html
-}
-
-//Creates a tinted image from a color image.
-void myTintImage(Mat& src, Mat& dst, int channel) {
-	dst = src.clone(); //the clone methods creates a deep copy of the matrix
-	for (int i = 0; i < src.rows; i++){
-		for (int j = 0; j < src.cols; j++){
-		//For each pixel, suppress the channels other than that passed in the argument of the function
-			dst.at<Vec3b>(i,j)[(channel + 1)%3] = 0;
-			dst.at<Vec3b>(i,j)[(channel + 2)%3] = 0;
-		}
+//Runs the batch mode: a chain of transforms on every input image
+int myBatchMain(const Options& opts)
+{
+	//chain=gray,threshold:128 lists the transforms, run in one pass over each image
+	TransformChain chain;
+	string error;
+	if (!chain.parse(opts.get("chain", "gray"), error))
+	{
+		cout << "Cannot use chain " << opts.get("chain", "gray") << ": " << error << endl;
+		return -1;
 	}
-}
-
-//Creates a thresholded image from a grayscale image.
-void myThresholdImage(Mat& src, Mat& dst, int threshold) {
-	dst = src.clone();
-	for (int i = 0; i < src.rows; i++){
-		for (int j = 0; j < src.cols; j++){
-			//For each pixel, assign intensity value of 0 if below threshold, else assign intensity value of 255
-			int intensity = src.at<uchar>(i,j);
-			if (intensity < threshold) {
-				dst.at<uchar>(i,j) = 0;
-			}
-			else {
-				dst.at<uchar>(i,j) = 255;
-			}
-		}
+	vector<string> files;
+	myListImages(opts.get("input"), files);
+	if (files.empty())
+	{
+		cout << "No images in " << opts.get("input") << endl;
+		return -1;
 	}
+
+	//the results go to output=DIR (default: the current directory), as ext=.png if given;
+	//threads=N workers, with at most inflight=N images in memory at a time
+	BatchStats stats = myRunBatch(files, chain, opts.get("output"), opts.get("ext"), opts.getInt("threads", 0), opts.getInt("inflight", 0));
+	double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+	cout << stats.images << " images in " << stats.seconds << " s (" << stats.images / seconds << " images/s, "
+		<< stats.megapixels / seconds << " MP/s), " << stats.failed << " failed" << endl;
+	return stats.failed > 0 ? 1 : 0;
 }
 
 //Other useful links:
@@ -0,0 +1,102 @@
+#include "TransformChain.h"
+
+#include <cstdlib>
+#include <sstream>
+
+#include "BandExecutor.h"
+#include "ImageTransforms.h"
+
+using namespace cv;
+using namespace std;
+
+bool TransformChain::parse(const string& spec, string& error)
+{
+	m_steps.clear();
+	int channels = 3;
+	stringstream list(spec);
+	string item;
+	while (getline(list, item, ',')) {
+		if (item.empty()) {
+			continue;
+		}
+		size_t colon = item.find(':');
+		string name = item.substr(0, colon);
+		bool hasValue = colon != string::npos;
+		int value = hasValue ? atoi(item.c_str() + colon + 1) : 0;
+		Step step;
+		if (name == "gray") {
+			step.kind = GRAY;
+			step.value = 0;
+		}
+		else if (name == "tint") {
+			step.kind = TINT;
+			step.value = hasValue ? value : 2;
+			if (step.value < 0 || step.value > 2) {
+				error = "the channel of tint is 0, 1 or 2";
+				return false;
+			}
+		}
+		else if (name == "threshold") {
+			step.kind = THRESHOLD;
+			step.value = hasValue ? value : 128;
+		}
+		else {
+			error = "unknown transform " + name;
+			return false;
+		}
+		// gray and tint take a color image, threshold a gray one
+		if ((step.kind == THRESHOLD) != (channels == 1)) {
+			error = item + (channels == 1 ? " needs a color image" : " needs a gray image: put gray before it");
+			return false;
+		}
+		channels = step.kind == GRAY ? 1 : channels;
+		m_steps.push_back(step);
+	}
+	if (m_steps.empty()) {
+		error = "no transform";
+		return false;
+	}
+	return true;
+}
+
+int TransformChain::outputChannels() const
+{
+	int channels = 3;
+	for (size_t k = 0; k < m_steps.size(); k++) {
+		if (m_steps[k].kind == GRAY) {
+			channels = 1;
+		}
+	}
+	return channels;
+}
+
+void TransformChain::apply(const Mat& src, Mat& dst) const
+{
+	dst.create(src.rows, src.cols, CV_8UC(outputChannels()));
+	if (src.empty()) {
+		return;
+	}
+	const vector<Step>& steps = m_steps;
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		// one color row between two transforms; tint and threshold work in place, so the row is reused
+		vector<uchar> row((size_t)src.cols * 3);
+		for (int i = first; i < end; i++){
+			const uchar* in = src.ptr<uchar>(i);
+			for (size_t k = 0; k < steps.size(); k++){
+				uchar* out = k + 1 == steps.size() ? dst.ptr<uchar>(i) : &row[0];
+				switch (steps[k].kind) {
+				case GRAY:
+					grayScaleRow(in, out, src.cols);
+					break;
+				case TINT:
+					tintRow(in, out, src.cols, steps[k].value);
+					break;
+				case THRESHOLD:
+					thresholdRow(in, out, src.cols, steps[k].value);
+					break;
+				}
+				in = out;
+			}
+		}
+	});
+}
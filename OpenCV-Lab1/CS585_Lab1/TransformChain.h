@@ -0,0 +1,56 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+TransformChain.h
+
+A chain of the lab transforms, such as "gray,threshold:128", run in one pass: every row of the image goes through
+all the transforms while it is in the cache, with one row buffer between two transforms, instead of one whole
+intermediate image per transform.
+*/
+class TransformChain {
+public:
+	/**
+	Function that reads a chain, returns false (with a message) if a transform is unknown or gets the wrong kind of image.
+	The transforms, separated by commas, are gray, tint:C (C = 0 blue, 1 green, 2 red; default 2) and threshold:T
+	(on a gray image; default 128)
+	@param spec The chain
+	@param error Receives the reason when the chain is rejected
+	*/
+	bool parse(const std::string& spec, std::string& error);
+
+	/**
+	Function that tells whether the chain has no transform
+	*/
+	bool empty() const { return m_steps.empty(); }
+
+	/**
+	Function that returns the number of channels of the result for a color source (1 or 3)
+	*/
+	int outputChannels() const;
+
+	/**
+	Runs the chain on an image, in bands of rows on the shared BandExecutor
+	@param src The source BGR image (CV_8UC3)
+	@param dst The destination, (re)allocated as CV_8UC1 or CV_8UC3 (see outputChannels)
+	*/
+	void apply(const cv::Mat& src, cv::Mat& dst) const;
+
+private:
+	enum Kind {
+		GRAY,		// 3 channels to 1
+		TINT,		// 3 channels to 3
+		THRESHOLD	// 1 channel to 1
+	};
+
+	struct Step {
+		Kind kind;
+		int value;	// channel of a tint, level of a threshold
+	};
+
+	std::vector<Step> m_steps;
+};
@@ -0,0 +1,53 @@
+#include "AllocCounter.h"
+
+#ifdef GESTURE_COUNT_ALLOCS
+
+#include <cstdlib>
+#include <new>
+
+static thread_local unsigned long long t_allocations = 0;
+
+static void* countedAlloc(size_t size)
+{
+	t_allocations++;
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { t_allocations++; return std::malloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { t_allocations++; return std::malloc(size ? size : 1); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+unsigned long long heapAllocationsOnThisThread()
+{
+	return t_allocations;
+}
+
+bool heapAllocationCountingEnabled()
+{
+	return true;
+}
+
+#else
+
+unsigned long long heapAllocationsOnThisThread()
+{
+	return 0;
+}
+
+bool heapAllocationCountingEnabled()
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+AllocCounter.h
+
+Debug counter of heap allocations, used to check that the analysis loop does not allocate once it has warmed up.
+When GESTURE_COUNT_ALLOCS is defined (Debug builds), AllocCounter.cpp replaces the global operator new/delete
+and counts every allocation per thread. Otherwise the counter is compiled out and always reads 0.
+Note that allocations made inside a DLL with its own runtime (e.g. opencv_world on Windows) are not seen.
+*/
+
+/**
+Function that returns the number of operator new calls made by the calling thread so far
+*/
+unsigned long long heapAllocationsOnThisThread();
+
+/**
+Function that tells whether allocation counting was compiled in
+*/
+bool heapAllocationCountingEnabled();
@@ -0,0 +1,107 @@
+#include "BackgroundModel.h"
+#include "BandExecutor.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace cv;
+
+//Gray level of a BGR triple with the fixed-point weights of cvtColor(CV_BGR2GRAY) for 8 bit images
+static inline int grayLevel(int b, int g, int r)
+{
+	return (b * 1868 + g * 9617 + r * 4899 + (1 << 13)) >> 14;
+}
+
+void frameDifferenceRow(const unsigned char* prev, const unsigned char* curr, unsigned char* mask, int width, int threshold)
+{
+	for (int j = 0; j < width; j++, prev += 3, curr += 3){
+		int gray = grayLevel(std::abs(curr[0] - prev[0]), std::abs(curr[1] - prev[1]), std::abs(curr[2] - prev[2]));
+		mask[j] = (unsigned char)-(int)(gray > threshold);
+	}
+}
+
+void frameDifferenceRowBits(const unsigned char* prev, const unsigned char* curr, unsigned long long* bits, int width, int threshold)
+{
+	for (int j = 0; j < width; j += 64){
+		unsigned long long w = 0;
+		int n = std::min(64, width - j);
+		for (int k = 0; k < n; k++, prev += 3, curr += 3){
+			int gray = grayLevel(std::abs(curr[0] - prev[0]), std::abs(curr[1] - prev[1]), std::abs(curr[2] - prev[2]));
+			w |= (unsigned long long)(gray > threshold) << k;
+		}
+		bits[j >> 6] = w;
+	}
+}
+
+BackgroundModel::BackgroundModel(Mode mode, double alpha, int threshold)
+	: m_mode(mode), m_alpha(std::min(256, std::max(1, cvRound(alpha * 256)))), m_threshold(threshold)
+{
+}
+
+void BackgroundModel::reset()
+{
+	m_background.release();
+}
+
+bool BackgroundModel::parseMode(const std::string& name, Mode& mode)
+{
+	if (name == "previous") {
+		mode = PREVIOUS_FRAME;
+	}
+	else if (name == "average") {
+		mode = RUNNING_AVERAGE;
+	}
+	else if (name == "median") {
+		mode = APPROX_MEDIAN;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+void BackgroundModel::apply(const Mat& frame, Mat& mask)
+{
+	mask.create(frame.rows, frame.cols, CV_8UC1);
+	if (m_background.rows != frame.rows || m_background.cols != frame.cols) {
+		//first frame: it becomes the background
+		frame.convertTo(m_background, CV_16UC3, 256);
+		mask.setTo(Scalar(0));
+		return;
+	}
+
+	const Mode mode = m_mode;
+	const int alpha = m_alpha;
+	const int threshold = m_threshold;
+	Mat& background = m_background;
+	BandExecutor::shared().run(frame.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			const uchar* f = frame.ptr<uchar>(i);
+			ushort* bg = background.ptr<ushort>(i);
+			uchar* m = mask.ptr<uchar>(i);
+			for (int j = 0; j < frame.cols; j++, f += 3, bg += 3){
+				int diff[3];
+				for (int c = 0; c < 3; c++){
+					int cur = f[c];
+					int b = bg[c];
+					diff[c] = std::abs(cur - ((b + 128) >> 8));
+					//update the background channel while it is in a register
+					int target = cur << 8;
+					if (mode == PREVIOUS_FRAME) {
+						b = target;
+					}
+					else if (mode == RUNNING_AVERAGE) {
+						b += ((target - b) * alpha) >> 8;
+					}
+					else {
+						// one gray level up or down (a multiply: shifting -1 left is undefined)
+						b += ((target > b) - (target < b)) * 256;
+						b = std::min(std::max(b, 0), 255 << 8);
+					}
+					bg[c] = (ushort)b;
+				}
+				m[j] = (uchar)-(int)(grayLevel(diff[0], diff[1], diff[2]) > threshold);
+			}
+		}
+	});
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <string>
+
+/**
+BackgroundModel.h
+
+Fused background subtraction: the current frame and the background are read once per pixel, the grayscale
+absolute difference is thresholded straight into the binary mask, and the background is updated in the same pass.
+The background is either the previous frame, an exponential running average, or an approximate running median,
+so slow lighting changes are absorbed instead of showing up as motion.
+*/
+
+/**
+Function that compares one row of two BGR images and writes the thresholded grayscale difference.
+The gray level of the per-channel absolute difference uses the same fixed-point weights as cvtColor(CV_BGR2GRAY)
+@param prev Pointer to the first pixel of the previous (or background) row, 3 bytes per pixel
+@param curr Pointer to the first pixel of the current row, 3 bytes per pixel
+@param mask Pointer to the destination row; 255 where the difference is above the threshold, 0 elsewhere
+@param width Number of pixels in the row
+@param threshold Gray level the difference has to exceed
+*/
+void frameDifferenceRow(const unsigned char* prev, const unsigned char* curr, unsigned char* mask, int width, int threshold);
+
+/**
+Bit-packed version of frameDifferenceRow (see BitMask.h)
+@param prev Pointer to the first pixel of the previous (or background) row, 3 bytes per pixel
+@param curr Pointer to the first pixel of the current row, 3 bytes per pixel
+@param bits Pointer to the first word of the destination row; the bits past width are cleared
+@param width Number of pixels in the row
+@param threshold Gray level the difference has to exceed
+*/
+void frameDifferenceRowBits(const unsigned char* prev, const unsigned char* curr, unsigned long long* bits, int width, int threshold);
+
+class BackgroundModel {
+public:
+	enum Mode {
+		PREVIOUS_FRAME,		// plain frame differencing
+		RUNNING_AVERAGE,	// background += alpha * (frame - background)
+		APPROX_MEDIAN		// background moves one gray level towards the frame per update
+	};
+
+	/**
+	@param mode How the background is updated
+	@param alpha Learning rate of the running average, in (0, 1]
+	@param threshold Gray level the difference has to exceed to count as foreground
+	*/
+	explicit BackgroundModel(Mode mode = RUNNING_AVERAGE, double alpha = 0.05, int threshold = 50);
+
+	/**
+	Writes the foreground mask of a frame and updates the background with it, in one pass.
+	The first frame (or a frame of a new size) only initialises the background and gives an empty mask
+	@param frame The current BGR frame
+	@param mask The destination CV_8UC1 mask (allocated if needed)
+	*/
+	void apply(const cv::Mat& frame, cv::Mat& mask);
+
+	/**
+	Forgets the background
+	*/
+	void reset();
+
+	/**
+	Function that reads a mode name ("previous", "average" or "median"), returns false if it is not one of them
+	@param name The name given on the command line
+	@param mode Receives the mode
+	*/
+	static bool parseMode(const std::string& name, Mode& mode);
+
+private:
+	Mode m_mode;
+	int m_alpha;			// learning rate in 1/256 units
+	int m_threshold;
+	cv::Mat m_background;	// CV_16UC3, 8.8 fixed point
+};
@@ -0,0 +1,195 @@
+#include "BitMask.h"
+#include "BandExecutor.h"
+
+#include <algorithm>
+
+using namespace cv;
+
+BitMask::BitMask() : m_rows(0), m_cols(0), m_stride(0)
+{
+}
+
+BitMask::BitMask(int rows, int cols) : m_rows(0), m_cols(0), m_stride(0)
+{
+	create(rows, cols);
+	clear();
+}
+
+void BitMask::create(int rows, int cols)
+{
+	m_rows = std::max(0, rows);
+	m_cols = std::max(0, cols);
+	m_stride = (m_cols + 63) >> 6;
+	m_words.resize((size_t)m_rows * m_stride);
+}
+
+void BitMask::clear()
+{
+	std::fill(m_words.begin(), m_words.end(), 0ULL);
+}
+
+void BitMask::set(int y, int x, bool value)
+{
+	unsigned long long bit = 1ULL << (x & 63);
+	unsigned long long& w = row(y)[x >> 6];
+	w = value ? (w | bit) : (w & ~bit);
+}
+
+void BitMask::orWith(const BitMask& other)
+{
+	CV_Assert(other.m_rows == m_rows && other.m_cols == m_cols);
+	for (size_t k = 0; k < m_words.size(); k++) {
+		m_words[k] |= other.m_words[k];
+	}
+}
+
+void BitMask::andWith(const BitMask& other)
+{
+	CV_Assert(other.m_rows == m_rows && other.m_cols == m_cols);
+	for (size_t k = 0; k < m_words.size(); k++) {
+		m_words[k] &= other.m_words[k];
+	}
+}
+
+//Horizontal 3-pixel erosion of word k of a row; the pixels left of the row and right of the last column count as set
+static inline unsigned long long erodeWord(const unsigned long long* r, int k, int n, unsigned long long lastMask)
+{
+	unsigned long long cur = k == n - 1 ? (r[k] | ~lastMask) : r[k];
+	unsigned long long prev = k > 0 ? r[k - 1] : ~0ULL;
+	unsigned long long next = k < n - 1 ? r[k + 1] : ~0ULL;
+	return cur & ((cur << 1) | (prev >> 63)) & ((cur >> 1) | (next << 63));
+}
+
+//Horizontal 3-pixel dilation of word k of a row; the bits past the last column are 0 so they add nothing
+static inline unsigned long long dilateWord(const unsigned long long* r, int k, int n)
+{
+	unsigned long long cur = r[k];
+	unsigned long long prev = k > 0 ? r[k - 1] : 0;
+	unsigned long long next = k < n - 1 ? r[k + 1] : 0;
+	return cur | (cur << 1) | (prev >> 63) | (cur >> 1) | (next << 63);
+}
+
+void BitMask::erode(BitMask& dst) const
+{
+	dst.create(m_rows, m_cols);
+	const int n = m_stride;
+	const unsigned long long lastMask = lastWordMask();
+	BandExecutor::shared().run(m_rows, [&](int first, int end) {
+		for (int i = first; i < end; i++) {
+			//rows above the first and below the last count as set, so they are left out of the AND
+			const unsigned long long* up = row(i > 0 ? i - 1 : i);
+			const unsigned long long* mid = row(i);
+			const unsigned long long* down = row(i < m_rows - 1 ? i + 1 : i);
+			unsigned long long* d = dst.row(i);
+			for (int k = 0; k < n; k++) {
+				d[k] = erodeWord(up, k, n, lastMask) & erodeWord(mid, k, n, lastMask) & erodeWord(down, k, n, lastMask);
+			}
+			d[n - 1] &= lastMask;
+		}
+	});
+}
+
+void BitMask::dilate(BitMask& dst) const
+{
+	dst.create(m_rows, m_cols);
+	const int n = m_stride;
+	const unsigned long long lastMask = lastWordMask();
+	BandExecutor::shared().run(m_rows, [&](int first, int end) {
+		for (int i = first; i < end; i++) {
+			const unsigned long long* up = i > 0 ? row(i - 1) : 0;
+			const unsigned long long* mid = row(i);
+			const unsigned long long* down = i < m_rows - 1 ? row(i + 1) : 0;
+			unsigned long long* d = dst.row(i);
+			for (int k = 0; k < n; k++) {
+				unsigned long long w = dilateWord(mid, k, n);
+				if (up) {
+					w |= dilateWord(up, k, n);
+				}
+				if (down) {
+					w |= dilateWord(down, k, n);
+				}
+				d[k] = w;
+			}
+			d[n - 1] &= lastMask;
+		}
+	});
+}
+
+long long BitMask::area() const
+{
+	long long count = 0;
+	for (size_t k = 0; k < m_words.size(); k++) {
+		count += popcount64(m_words[k]);
+	}
+	return count;
+}
+
+long long BitMask::area(const Rect& roi) const
+{
+	int x0 = std::max(roi.x, 0), x1 = std::min(roi.x + roi.width, m_cols);
+	int y0 = std::max(roi.y, 0), y1 = std::min(roi.y + roi.height, m_rows);
+	if (x0 >= x1 || y0 >= y1) {
+		return 0;
+	}
+	const int k0 = x0 >> 6, k1 = (x1 - 1) >> 6;
+	const unsigned long long first = ~0ULL << (x0 & 63);
+	const unsigned long long last = ~0ULL >> (63 - ((x1 - 1) & 63));
+	long long count = 0;
+	for (int i = y0; i < y1; i++) {
+		const unsigned long long* r = row(i);
+		if (k0 == k1) {
+			count += popcount64(r[k0] & first & last);
+			continue;
+		}
+		count += popcount64(r[k0] & first);
+		for (int k = k0 + 1; k < k1; k++) {
+			count += popcount64(r[k]);
+		}
+		count += popcount64(r[k1] & last);
+	}
+	return count;
+}
+
+double BitMask::density(const Rect& roi) const
+{
+	int x0 = std::max(roi.x, 0), x1 = std::min(roi.x + roi.width, m_cols);
+	int y0 = std::max(roi.y, 0), y1 = std::min(roi.y + roi.height, m_rows);
+	if (x0 >= x1 || y0 >= y1) {
+		return 0;
+	}
+	return (double)area(roi) / ((double)(x1 - x0) * (y1 - y0));
+}
+
+void BitMask::fromMat(const Mat& mask)
+{
+	CV_Assert(mask.type() == CV_8UC1);
+	create(mask.rows, mask.cols);
+	BandExecutor::shared().run(m_rows, [&](int first, int end) {
+		for (int i = first; i < end; i++) {
+			const uchar* m = mask.ptr<uchar>(i);
+			unsigned long long* d = row(i);
+			for (int k = 0; k < m_stride; k++) {
+				unsigned long long w = 0;
+				int n = std::min(64, m_cols - (k << 6));
+				for (int b = 0; b < n; b++) {
+					w |= (unsigned long long)(m[(k << 6) + b] != 0) << b;
+				}
+				d[k] = w;
+			}
+		}
+	});
+}
+
+void BitMask::toMat(Mat& dst) const
+{
+	dst.create(m_rows, m_cols, CV_8UC1);
+	BandExecutor::shared().run(m_rows, [&](int first, int end) {
+		for (int i = first; i < end; i++) {
+			const unsigned long long* r = row(i);
+			uchar* d = dst.ptr<uchar>(i);
+			for (int j = 0; j < m_cols; j++) {
+				d[j] = (uchar)-(int)((r[j >> 6] >> (j & 63)) & 1);
+			}
+		}
+	});
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+/**
+BitMask.h
+
+Binary mask with one bit per pixel. The CV_8UC1 masks of the pipeline only ever hold 0 or 255, so packing them
+cuts their memory traffic by 8. Each row is a run of 64-bit words: bit j % 64 of word j / 64 is pixel j, and the
+bits past the last column are always 0. OR/AND, 3x3 erode/dilate and the area queries work on whole words
+(64 pixels per instruction) and run in bands of rows on the shared BandExecutor.
+*/
+class BitMask {
+public:
+	BitMask();
+
+	/**
+	Creates a cleared mask
+	@param rows Number of rows
+	@param cols Number of columns
+	*/
+	BitMask(int rows, int cols);
+
+	/**
+	Gives the mask a size; the storage is kept when it is large enough. The contents are undefined afterwards,
+	the kernels that write a mask write every word
+	@param rows Number of rows
+	@param cols Number of columns
+	*/
+	void create(int rows, int cols);
+
+	/**
+	Sets every pixel to 0
+	*/
+	void clear();
+
+	int rows() const { return m_rows; }
+	int cols() const { return m_cols; }
+	bool empty() const { return m_rows == 0 || m_cols == 0; }
+
+	/**
+	Function that returns the number of 64-bit words per row
+	*/
+	int wordsPerRow() const { return m_stride; }
+
+	/**
+	Function that returns the first word of a row
+	@param i The row
+	*/
+	unsigned long long* row(int i) { return &m_words[(size_t)i * m_stride]; }
+	const unsigned long long* row(int i) const { return &m_words[(size_t)i * m_stride]; }
+
+	/**
+	Function that returns the value of one pixel
+	*/
+	bool get(int y, int x) const { return ((row(y)[x >> 6] >> (x & 63)) & 1) != 0; }
+
+	/**
+	Sets or clears one pixel
+	*/
+	void set(int y, int x, bool value);
+
+	/**
+	Function that ORs another mask of the same size into this one
+	@param other The mask to add
+	*/
+	void orWith(const BitMask& other);
+
+	/**
+	Function that ANDs another mask of the same size into this one
+	@param other The mask to intersect with
+	*/
+	void andWith(const BitMask& other);
+
+	/**
+	Function that erodes the mask with a 3x3 square; pixels outside the mask count as set, as in cv::erode
+	@param dst The destination mask (must not be this one)
+	*/
+	void erode(BitMask& dst) const;
+
+	/**
+	Function that dilates the mask with a 3x3 square; pixels outside the mask count as cleared, as in cv::dilate
+	@param dst The destination mask (must not be this one)
+	*/
+	void dilate(BitMask& dst) const;
+
+	/**
+	Function that returns the number of set pixels
+	*/
+	long long area() const;
+
+	/**
+	Function that returns the number of set pixels inside a rectangle (clipped to the mask)
+	@param roi The rectangle
+	*/
+	long long area(const cv::Rect& roi) const;
+
+	/**
+	Function that returns the fraction of set pixels inside a rectangle, 0 for an empty rectangle
+	@param roi The rectangle
+	*/
+	double density(const cv::Rect& roi) const;
+
+	/**
+	Packs a CV_8UC1 mask; every non-zero pixel is set
+	@param mask The source mask
+	*/
+	void fromMat(const cv::Mat& mask);
+
+	/**
+	Function that unpacks the mask into a CV_8UC1 image with 255 for set pixels and 0 for the rest
+	@param dst The destination image (allocated if needed)
+	*/
+	void toMat(cv::Mat& dst) const;
+
+	/**
+	Function that returns the mask of the valid bits of the last word of a row
+	*/
+	unsigned long long lastWordMask() const { return (m_cols & 63) ? (1ULL << (m_cols & 63)) - 1 : ~0ULL; }
+
+private:
+	int m_rows;
+	int m_cols;
+	int m_stride;
+	std::vector<unsigned long long> m_words;
+};
+
+/**
+Function that returns the number of set bits of a word
+*/
+inline int popcount64(unsigned long long w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(w);
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
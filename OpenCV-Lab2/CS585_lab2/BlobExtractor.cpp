@@ -0,0 +1,176 @@
+#include "BlobExtractor.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace cv;
+
+BlobExtractor::BlobExtractor() : m_threshold(0)
+{
+}
+
+int BlobExtractor::findRoot(int i)
+{
+	while (m_parent[i] != i) {
+		//path halving
+		m_parent[i] = m_parent[m_parent[i]];
+		i = m_parent[i];
+	}
+	return i;
+}
+
+void BlobExtractor::unite(int a, int b)
+{
+	a = findRoot(a);
+	b = findRoot(b);
+	if (a == b) {
+		return;
+	}
+	//the older run stays the root, so a root is always the first run (topmost, leftmost) of its blob
+	if (b < a) {
+		std::swap(a, b);
+	}
+	m_parent[b] = a;
+	m_area[a] += m_area[b];
+	m_box[a] |= m_box[b];
+}
+
+int BlobExtractor::extract(const Mat& mask, int threshold, int minArea)
+{
+	CV_Assert(mask.type() == CV_8UC1 && threshold >= 0);
+	m_threshold = threshold;
+	m_runs.clear();
+	m_parent.clear();
+	m_area.clear();
+	m_box.clear();
+	m_blobs.clear();
+
+	int prevBegin = 0, prevEnd = 0;
+	for (int y = 0; y < mask.rows; y++) {
+		const uchar* p = mask.ptr<uchar>(y);
+		int x = 0;
+		while (x < mask.cols) {
+			//skip background, 8 pixels at a time where the mask is all zero
+			while (x + 8 <= mask.cols) {
+				unsigned long long w;
+				std::memcpy(&w, p + x, 8);
+				if (w != 0) {
+					break;
+				}
+				x += 8;
+			}
+			while (x < mask.cols && p[x] <= threshold) {
+				x++;
+			}
+			if (x == mask.cols) {
+				break;
+			}
+			int x0 = x;
+			while (x < mask.cols && p[x] > threshold) {
+				x++;
+			}
+
+			Run r = { x0, x, y };
+			int id = (int)m_runs.size();
+			m_runs.push_back(r);
+			m_parent.push_back(id);
+			m_area.push_back(x - x0);
+			m_box.push_back(Rect(x0, y, x - x0, 1));
+
+			//runs of the row above that touch this one, including diagonally
+			while (prevBegin < prevEnd && m_runs[prevBegin].x1 < x0) {
+				prevBegin++;
+			}
+			for (int k = prevBegin; k < prevEnd && m_runs[k].x0 <= x; k++) {
+				unite(k, id);
+			}
+		}
+		//the runs of this row become the row above; prevBegin starts at the first of them
+		prevBegin = prevEnd;
+		prevEnd = (int)m_runs.size();
+	}
+
+	//one blob per root, in scan order
+	int largest = -1;
+	for (int i = 0; i < (int)m_runs.size(); i++) {
+		if (m_parent[i] != i) {
+			continue;
+		}
+		Blob b;
+		b.area = m_area[i];
+		b.bbox = m_box[i];
+		b.start = Point(m_runs[i].x0, m_runs[i].y);
+		if (b.area >= minArea && (largest < 0 || b.area > m_blobs[largest].area)) {
+			largest = (int)m_blobs.size();
+		}
+		m_blobs.push_back(b);
+	}
+	return largest;
+}
+
+//The 8 neighbours in clockwise order on screen (y points down), starting east
+static const int DX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int DY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+void BlobExtractor::traceOuterContour(const Mat& mask, int blob, std::vector<Point>& contour, Point offset) const
+{
+	contour.clear();
+	m_path.clear();
+	m_dirs.clear();
+	if (blob < 0 || blob >= (int)m_blobs.size()) {
+		return;
+	}
+	const int threshold = m_threshold;
+	//other blobs are never 8-adjacent to this one, so every foreground neighbour met on the way belongs to it
+	auto inside = [&](int x, int y) {
+		return x >= 0 && y >= 0 && x < mask.cols && y < mask.rows && mask.ptr<uchar>(y)[x] > threshold;
+	};
+
+	const Point start = m_blobs[blob].start;
+	Point p = start;
+	//the start pixel is topmost-leftmost, so its west neighbour is background
+	int back = 4;
+	int firstDir = -1;
+	for (;;) {
+		int d = -1;
+		for (int k = 1; k <= 8; k++) {
+			int c = (back + k) & 7;
+			if (inside(p.x + DX[c], p.y + DY[c])) {
+				d = c;
+				break;
+			}
+		}
+		if (d < 0) {
+			//isolated pixel
+			m_path.push_back(p);
+			m_dirs.push_back(0);
+			break;
+		}
+		if (p == start) {
+			if (firstDir < 0) {
+				firstDir = d;
+			}
+			else if (d == firstDir) {
+				//back at the start, leaving the same way as the first time: the boundary is closed
+				break;
+			}
+		}
+		m_path.push_back(p);
+		m_dirs.push_back((unsigned char)d);
+		//the last background neighbour checked becomes the backtrack of the next pixel
+		Point q(p.x + DX[d], p.y + DY[d]);
+		int c = (d + 7) & 7;
+		int bx = p.x + DX[c] - q.x, by = p.y + DY[c] - q.y;
+		for (back = 0; back < 8 && (DX[back] != bx || DY[back] != by); back++) {
+		}
+		p = q;
+	}
+
+	//keep the points where the direction changes (the direction into point i is m_dirs[i - 1])
+	int n = (int)m_path.size();
+	for (int i = 0; i < n; i++) {
+		if (i == 0 || n == 1 || m_dirs[i] != m_dirs[i - 1]) {
+			contour.push_back(m_path[i] + offset);
+		}
+	}
+}
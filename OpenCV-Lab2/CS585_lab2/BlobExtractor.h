@@ -0,0 +1,73 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+/**
+BlobExtractor.h
+
+Streaming connected-component extraction for the "find the hand" step. The mask is read once, row by row, as runs
+of foreground pixels; each run is joined with the 8-connected runs of the row above through union-find, and the
+area and bounding box of every blob are kept up to date as the runs are merged. No hierarchy and no contour is built
+for blobs that are not needed: only the outer boundary of the chosen blob is traced afterwards, for the hull stage.
+*/
+
+/**
+One 8-connected blob of foreground pixels
+*/
+struct Blob {
+	int area;			// number of pixels
+	cv::Rect bbox;		// bounding box, in mask coordinates
+	cv::Point start;	// topmost, then leftmost pixel; the outer boundary is traced from there
+};
+
+class BlobExtractor {
+public:
+	BlobExtractor();
+
+	/**
+	Function that labels the blobs of a mask and returns the index of the largest one in blobs(),
+	or -1 when no blob reaches minArea pixels
+	@param mask The CV_8UC1 mask
+	@param threshold A pixel is foreground when its value is above threshold
+	@param minArea Blobs with fewer pixels are not considered for the largest
+	*/
+	int extract(const cv::Mat& mask, int threshold = 0, int minArea = 1);
+
+	/**
+	Function that returns the blobs found by the last extract()
+	*/
+	const std::vector<Blob>& blobs() const { return m_blobs; }
+
+	/**
+	Function that traces the outer boundary of a blob clockwise (Moore neighbour tracing), keeping only the points
+	where the direction changes, like CV_CHAIN_APPROX_SIMPLE
+	@param mask The mask given to extract()
+	@param blob Index of the blob in blobs()
+	@param contour Receives the boundary points
+	@param offset Added to every point, e.g. the top-left corner of the region the mask was cut from
+	*/
+	void traceOuterContour(const cv::Mat& mask, int blob, std::vector<cv::Point>& contour, cv::Point offset = cv::Point()) const;
+
+private:
+	struct Run {
+		int x0;		// first pixel
+		int x1;		// one past the last pixel
+		int y;
+	};
+
+	int findRoot(int i);
+	void unite(int a, int b);
+
+	int m_threshold;
+	std::vector<Run> m_runs;
+	std::vector<int> m_parent;
+	// per root run: pixel count and bounding box of its set
+	std::vector<int> m_area;
+	std::vector<cv::Rect> m_box;
+	std::vector<Blob> m_blobs;
+	// scratch of the tracer: boundary pixels and the direction taken from each
+	mutable std::vector<cv::Point> m_path;
+	mutable std::vector<unsigned char> m_dirs;
+};
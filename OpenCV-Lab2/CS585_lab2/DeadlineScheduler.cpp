@@ -0,0 +1,97 @@
+#include "DeadlineScheduler.h"
+
+#include <algorithm>
+
+//weight of a new measurement in the moving averages
+static const double COST_WEIGHT = 0.2;
+
+static void smooth(double& average, double ms)
+{
+	average += COST_WEIGHT * (ms - average);
+}
+
+DeadlineScheduler::DeadlineScheduler(double deadlineMs, int recoverFrames)
+	: m_deadlineMs(std::max(0.0, deadlineMs)), m_recoverFrames(std::max(1, recoverFrames)), m_level(LEVEL_FULL), m_roomy(0),
+	m_motionMs(0), m_analysisMs(0), m_overlayMs(0), m_drawMs(0), m_renderMs(0)
+{
+	std::fill(m_frames, m_frames + LEVEL_COUNT, 0ULL);
+}
+
+double DeadlineScheduler::cost(int level) const
+{
+	double ms = m_analysisMs + m_renderMs;
+	if (level < LEVEL_NO_MOTION) {
+		ms += m_motionMs;
+	}
+	if (level < LEVEL_NO_OVERLAY) {
+		ms += m_overlayMs + m_drawMs;
+	}
+	return ms;
+}
+
+FrameLevel DeadlineScheduler::plan(double ageMs)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (!enabled()) {
+		m_frames[LEVEL_FULL]++;
+		return LEVEL_FULL;
+	}
+	if (ageMs >= m_deadlineMs) {
+		m_frames[LEVEL_SKIP]++;
+		return LEVEL_SKIP;
+	}
+	// the fullest level that still makes the deadline; the analysis itself always runs
+	int fits = LEVEL_FULL;
+	while (fits < LEVEL_NO_MOTION && ageMs + cost(fits) > m_deadlineMs) {
+		fits++;
+	}
+	if (fits > m_level) {
+		// late: degrade at once
+		m_level = fits;
+		m_roomy = 0;
+	}
+	else if (fits < m_level && ++m_roomy >= m_recoverFrames) {
+		// room to spare for a while: one step back up
+		m_level--;
+		m_roomy = 0;
+	}
+	else if (fits == m_level) {
+		m_roomy = 0;
+	}
+	m_frames[m_level]++;
+	return (FrameLevel)m_level;
+}
+
+void DeadlineScheduler::record(FrameLevel level, double motionMs, double analysisMs, double overlayMs)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (level == LEVEL_SKIP) {
+		return;
+	}
+	// only the stages that ran are measured; the others keep their last estimate
+	smooth(m_analysisMs, analysisMs);
+	if (level < LEVEL_NO_MOTION) {
+		smooth(m_motionMs, motionMs);
+	}
+	if (level < LEVEL_NO_OVERLAY) {
+		smooth(m_overlayMs, overlayMs);
+	}
+}
+
+void DeadlineScheduler::recordRender(FrameLevel level, double overlayMs, double renderMs)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (level == LEVEL_SKIP) {
+		return;
+	}
+	if (level < LEVEL_NO_OVERLAY) {
+		smooth(m_drawMs, overlayMs);
+	}
+	smooth(m_renderMs, renderMs);
+}
+
+unsigned long long DeadlineScheduler::frames(FrameLevel level) const
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_frames[level];
+}
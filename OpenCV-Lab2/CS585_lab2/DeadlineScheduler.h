@@ -0,0 +1,86 @@
+#pragma once
+
+#include <mutex>
+
+/**
+DeadlineScheduler.h
+
+Frame scheduler that keeps the time from capture to presentation under a deadline. Before a frame is analysed,
+the time it has already waited and the recent cost of each optional stage tell whether it can still make the
+deadline: the frame then runs everything, or without the overlays (drawn by the display thread), or also without
+the background subtraction and motion history; a frame that has already missed the deadline is skipped, so a backlog
+drains instead of adding its delay to every following frame. The level drops at once when frames run late and
+comes back one step at a time after a run of frames with room to spare, so the output degrades and recovers smoothly.
+The working scale of the coarse-to-fine mode (ScaleController.h) is the other, independent, way to keep up.
+*/
+
+/**
+What runs on a frame, from everything to nothing
+*/
+enum FrameLevel {
+	LEVEL_FULL,			// motion, analysis and overlays
+	LEVEL_NO_OVERLAY,	// motion and analysis; the frame is shown without overlays
+	LEVEL_NO_MOTION,	// analysis only
+	LEVEL_SKIP,			// not analysed: it had already missed the deadline
+	LEVEL_COUNT
+};
+
+class DeadlineScheduler {
+public:
+	/**
+	@param deadlineMs Time from capture to presentation to stay under, in milliseconds; 0 runs every stage on every frame
+	@param recoverFrames Frames in a row with room for a fuller level before the level goes up one step
+	*/
+	explicit DeadlineScheduler(double deadlineMs = 0, int recoverFrames = 8);
+
+	/**
+	Function that tells whether a deadline is set
+	*/
+	bool enabled() const { return m_deadlineMs > 0; }
+
+	/**
+	Function that decides what runs on a frame
+	@param ageMs Time since the frame was captured, in milliseconds
+	*/
+	FrameLevel plan(double ageMs);
+
+	/**
+	Records the cost of the stages that ran on a frame planned at a level (stages that did not run are passed as 0)
+	@param level The level of the frame
+	@param motionMs Background subtraction and motion history
+	@param analysisMs Hand analysis
+	@param overlayMs Copying the overlays for the display thread
+	*/
+	void record(FrameLevel level, double motionMs, double analysisMs, double overlayMs);
+
+	/**
+	Records the time the display thread took to draw the overlays of a frame and to show it. May be called from another thread
+	@param level The level of the frame
+	@param overlayMs Drawing the overlays (0 when the level has none)
+	@param renderMs Showing the frame and the masks
+	*/
+	void recordRender(FrameLevel level, double overlayMs, double renderMs);
+
+	/**
+	Function that returns how many frames were planned at a level
+	@param level The level
+	*/
+	unsigned long long frames(FrameLevel level) const;
+
+private:
+	//predicted time from now to presentation for a frame at a level
+	double cost(int level) const;
+
+	double m_deadlineMs;
+	int m_recoverFrames;
+	int m_level;			// current level (never LEVEL_SKIP, which is decided per frame)
+	int m_roomy;			// frames in a row that had room for the level above
+	// exponential moving averages of the stage costs, in milliseconds
+	double m_motionMs;
+	double m_analysisMs;
+	double m_overlayMs;		// copying the overlays on the analysis thread
+	double m_drawMs;		// drawing them on the display thread
+	double m_renderMs;		// showing the frame, paid at every level
+	unsigned long long m_frames[LEVEL_COUNT];
+	mutable std::mutex m_lock;	// plan and record run on the analysis thread, recordRender on the display thread
+};
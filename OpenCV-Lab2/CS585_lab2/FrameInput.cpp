@@ -0,0 +1,70 @@
+#include "FrameInput.h"
+
+#include <sys/stat.h>
+
+using namespace cv;
+using namespace std;
+
+FrameInput::FrameInput() : m_nextFile(0), m_live(false)
+{
+}
+
+bool FrameInput::open(const string& input)
+{
+	release();
+	if (input.empty() || input.find_first_not_of("0123456789") == string::npos)
+	{
+		// open the video camera with that number
+		m_live = true;
+		m_cap.open(input.empty() ? 0 : atoi(input.c_str()));
+		return m_cap.isOpened();
+	}
+	if (myIsDirectory(input))
+	{
+		glob(input, m_files, false);
+		return !m_files.empty();
+	}
+	if (RawReplay::isRecording(input))
+	{
+		return m_replay.open(input);
+	}
+	m_cap.open(input);
+	return m_cap.isOpened();
+}
+
+bool FrameInput::read(Mat& frame)
+{
+	if (m_replay.isOpen())
+	{
+		return m_replay.read(frame);
+	}
+	if (!m_cap.isOpened())
+	{
+		// the images of the directory in name order
+		while (m_nextFile < m_files.size())
+		{
+			frame = imread(m_files[m_nextFile++]);
+			if (!frame.empty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	return m_cap.read(frame);
+}
+
+void FrameInput::release()
+{
+	m_cap.release();
+	m_replay.close();
+	m_files.clear();
+	m_nextFile = 0;
+	m_live = false;
+}
+
+//Function that tells whether a path names an existing directory
+bool myIsDirectory(const string& path) {
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR;
+}
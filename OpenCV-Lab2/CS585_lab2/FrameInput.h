@@ -0,0 +1,56 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include <string>
+#include <vector>
+
+#include "RawVideo.h"
+
+/**
+FrameInput.h
+
+Source of frames for the analysis: a camera, a video file, a directory of images (read in name order) or a raw
+recording (see RawVideo.h), whose frames point straight into the mapped file.
+*/
+class FrameInput {
+public:
+	FrameInput();
+
+	/**
+	Function that opens a source, returns false if it cannot be opened
+	@param input A camera number ("0", "1", ...), a video file, a directory of images or a raw recording; empty for camera 0
+	*/
+	bool open(const std::string& input);
+
+	/**
+	Function that reads the next frame, returns false at the end of the source. Image files that do not decode are skipped
+	@param frame Receives the frame, reusing its buffer when possible. Frames of a raw recording are headers into
+	the read-only mapping instead, valid until release()
+	*/
+	bool read(cv::Mat& frame);
+
+	/**
+	Function that tells whether the source is a live camera (whose frames may be dropped when the analysis falls behind)
+	*/
+	bool live() const { return m_live; }
+
+	/**
+	Closes the source
+	*/
+	void release();
+
+private:
+	cv::VideoCapture m_cap;
+	RawReplay m_replay;
+	std::vector<cv::String> m_files;
+	size_t m_nextFile;
+	bool m_live;
+};
+
+/**
+Function that tells whether a path names an existing directory
+@param path The path to test
+*/
+bool myIsDirectory(const std::string& path);
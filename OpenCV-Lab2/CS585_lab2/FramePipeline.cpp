@@ -0,0 +1,149 @@
+#include "FramePipeline.h"
+
+#include "AllocCounter.h"
+#include "StageProfiler.h"
+
+#include <chrono>
+
+//Backs off while a ring is empty: a few yields first, then short sleeps so an idle stage does not burn a core
+static void idleWait(int& spins)
+{
+	if (spins < 16) {
+		std::this_thread::yield();
+	}
+	else {
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	spins++;
+}
+
+FramePipeline::FramePipeline(FrameSource source, AnalyzeFn analyze, int queueCapacity, bool dropFrames)
+	: m_source(source), m_analyze(analyze), m_dropFrames(dropFrames), m_captured(queueCapacity), m_analysed(queueCapacity),
+	m_stop(false), m_captureDone(false), m_analysisDone(false),
+	m_capturedCount(0), m_analysedCount(0), m_droppedCapture(0), m_droppedPresent(0)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+	stop();
+}
+
+void FramePipeline::start()
+{
+	m_captureThread = std::thread(&FramePipeline::captureLoop, this);
+	m_analysisThread = std::thread(&FramePipeline::analysisLoop, this);
+}
+
+void FramePipeline::stop()
+{
+	m_stop = true;
+	if (m_captureThread.joinable()) {
+		m_captureThread.join();
+	}
+	if (m_analysisThread.joinable()) {
+		m_analysisThread.join();
+	}
+}
+
+bool FramePipeline::forward(BoundedRing<PipelineFrame>& ring, PipelineFrame& pf, std::atomic<unsigned long long>& dropped)
+{
+	if (m_dropFrames) {
+		dropped += ring.pushDropOldest(pf);
+		return true;
+	}
+	int spins = 0;
+	while (!ring.tryPush(pf)) {
+		if (m_stop) {
+			return false;
+		}
+		idleWait(spins);
+	}
+	return true;
+}
+
+//Stage 1: reads frames as fast as the source delivers them
+void FramePipeline::captureLoop()
+{
+	PipelineFrame pf;
+	unsigned long long index = 0;
+	while (!m_stop) {
+		ScopedStageTimer captureTimer(PROFILE_CAPTURE);
+		if (!m_source(pf.frame) || pf.frame.empty()) {
+			break;
+		}
+		captureTimer.stop();
+		pf.captureTick = cv::getTickCount();
+		pf.index = index++;
+		m_capturedCount++;
+		//after the push pf holds the recycled contents of the slot, so the source can reuse its buffer
+		if (!forward(m_captured, pf, m_droppedCapture)) {
+			break;
+		}
+	}
+	m_captureDone = true;
+}
+
+//Stage 2: runs the analysis on every frame that reaches it
+void FramePipeline::analysisLoop()
+{
+	PipelineFrame pf;
+	int spins = 0;
+	while (!m_stop) {
+		if (!m_captured.tryPop(pf)) {
+			if (m_captureDone && m_captured.size() == 0) {
+				break;
+			}
+			idleWait(spins);
+			continue;
+		}
+		spins = 0;
+		unsigned long long allocationsBefore = heapAllocationsOnThisThread();
+		m_analyze(pf);
+		pf.allocations = heapAllocationsOnThisThread() - allocationsBefore;
+		m_analysedCount++;
+		if (!forward(m_analysed, pf, m_droppedPresent)) {
+			break;
+		}
+	}
+	m_analysisDone = true;
+}
+
+bool FramePipeline::nextResult(PipelineFrame& out)
+{
+	return m_analysed.tryPop(out);
+}
+
+bool FramePipeline::waitResult(PipelineFrame& out)
+{
+	int spins = 0;
+	while (!m_analysed.tryPop(out)) {
+		if (finished()) {
+			return false;
+		}
+		idleWait(spins);
+	}
+	return true;
+}
+
+bool FramePipeline::finished() const
+{
+	return m_analysisDone && m_analysed.size() == 0;
+}
+
+PipelineStats FramePipeline::stats() const
+{
+	PipelineStats s;
+	s.captureQueueDepth = m_captured.size();
+	s.presentQueueDepth = m_analysed.size();
+	s.captured = m_capturedCount;
+	s.analysed = m_analysedCount;
+	s.droppedCapture = m_droppedCapture;
+	s.droppedPresent = m_droppedPresent;
+	return s;
+}
+
+double FramePipeline::latencyMs(const PipelineFrame& pf)
+{
+	return (cv::getTickCount() - pf.captureTick) * 1000.0 / cv::getTickFrequency();
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "BoundedRing.h"
+#include "DeadlineScheduler.h"
+#include "HandAnalysis.h"
+
+/**
+FramePipeline.h
+
+Three-stage capture -> analysis -> presentation pipeline.
+Capture and analysis run on their own threads; presentation is pulled by the caller
+(the highgui thread) with nextResult. The stages are connected by lock-free rings that drop
+the oldest frame when the next stage falls behind, so latency does not build up.
+For offline processing the rings can instead make a stage wait, so every frame of the source is analysed.
+*/
+
+/**
+One frame travelling through the pipeline
+*/
+struct PipelineFrame {
+	cv::Mat frame;				// captured BGR frame; the overlays are drawn on it when it is shown
+	cv::Mat skin;				// skin mask filled in by the analysis stage
+	cv::Mat motion;				// foreground mask from background subtraction (motion=1 only)
+	cv::Mat motionEnergy;		// motion energy over the history window (motion=1 only)
+	unsigned long long index;	// capture order, starting at 0
+	long long captureTick;		// cv::getTickCount() right after the frame was read
+	unsigned long long allocations;	// heap allocations made by the analysis stage for this frame (see AllocCounter.h)
+	HandResult hand;			// gesture, bounding box and stage timings filled in by the analysis stage
+	HandOverlay overlay;		// what the display draws on the frame, when the analysis stage captured it
+	FrameLevel level;			// what ran on the frame (see DeadlineScheduler.h)
+
+	PipelineFrame() : index(0), captureTick(0), allocations(0), level(LEVEL_FULL) {}
+};
+
+/**
+Snapshot of the pipeline counters
+*/
+struct PipelineStats {
+	size_t captureQueueDepth;			// frames waiting for analysis
+	size_t presentQueueDepth;			// analysed frames waiting for presentation
+	unsigned long long captured;		// frames read from the camera
+	unsigned long long analysed;		// frames that went through the analysis stage
+	unsigned long long droppedCapture;	// frames evicted before analysis
+	unsigned long long droppedPresent;	// analysed frames evicted before presentation
+};
+
+class FramePipeline {
+public:
+	typedef std::function<bool(cv::Mat&)> FrameSource;
+	typedef std::function<void(PipelineFrame&)> AnalyzeFn;
+
+	/**
+	Creates the pipeline; no thread is started yet
+	@param source Function that reads the next frame into its argument (reusing its buffer), returns false at the end of the source.
+	Called only by the capture thread from start() on
+	@param analyze Function run on the analysis thread for every frame that is not dropped
+	@param queueCapacity Capacity of each of the two rings
+	@param dropFrames true to evict the oldest frame when a stage falls behind (live camera),
+	false to make the earlier stage wait instead (files: every frame is analysed and handed out)
+	*/
+	FramePipeline(FrameSource source, AnalyzeFn analyze, int queueCapacity = 4, bool dropFrames = true);
+
+	/**
+	Stops and joins the stage threads
+	*/
+	~FramePipeline();
+
+	/**
+	Starts the capture and analysis threads
+	*/
+	void start();
+
+	/**
+	Asks both stages to stop and waits for them
+	*/
+	void stop();
+
+	/**
+	Function that takes the oldest analysed frame, returns false if none is ready yet
+	@param out Receives the frame; its previous buffers are recycled by the pipeline
+	*/
+	bool nextResult(PipelineFrame& out);
+
+	/**
+	Function that waits for the next analysed frame, returns false once the pipeline has finished
+	@param out Receives the frame; its previous buffers are recycled by the pipeline
+	*/
+	bool waitResult(PipelineFrame& out);
+
+	/**
+	Function that tells whether the source has ended and every frame has been handed out
+	*/
+	bool finished() const;
+
+	/**
+	Function that returns the current queue depths and frame counters
+	*/
+	PipelineStats stats() const;
+
+	/**
+	Function that returns the time in milliseconds from the capture of a frame until now
+	@param pf Frame filled in by the pipeline
+	*/
+	static double latencyMs(const PipelineFrame& pf);
+
+private:
+	FramePipeline(const FramePipeline&);
+	FramePipeline& operator=(const FramePipeline&);
+
+	void captureLoop();
+	void analysisLoop();
+	//hands a frame to the next ring, dropping or waiting as configured; returns false if stopped while waiting
+	bool forward(BoundedRing<PipelineFrame>& ring, PipelineFrame& pf, std::atomic<unsigned long long>& dropped);
+
+	FrameSource m_source;
+	AnalyzeFn m_analyze;
+	const bool m_dropFrames;
+	BoundedRing<PipelineFrame> m_captured;
+	BoundedRing<PipelineFrame> m_analysed;
+	std::thread m_captureThread;
+	std::thread m_analysisThread;
+
+	std::atomic<bool> m_stop;
+	std::atomic<bool> m_captureDone;
+	std::atomic<bool> m_analysisDone;
+	std::atomic<unsigned long long> m_capturedCount;
+	std::atomic<unsigned long long> m_analysedCount;
+	std::atomic<unsigned long long> m_droppedCapture;
+	std::atomic<unsigned long long> m_droppedPresent;
+};
@@ -0,0 +1,112 @@
+#include "GestureCApi.h"
+#include "GestureEngine.h"
+
+#include <exception>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct gesture_engine {
+	GestureEngine engine;
+	GestureResult result;
+	vector<gesture_point> fingertips;
+	vector<gesture_point> hull;
+	string error;
+
+	explicit gesture_engine(const Options& opts) : engine(opts), error(engine.messages()) {}
+};
+
+//Copies points into the C layout
+static void copyPoints(const vector<cv::Point>& from, vector<gesture_point>& to)
+{
+	to.resize(from.size());
+	for (size_t i = 0; i < from.size(); i++) {
+		to[i].x = from[i].x;
+		to[i].y = from[i].y;
+	}
+}
+
+gesture_engine* gesture_engine_create(const char* options)
+{
+	try {
+		return new gesture_engine(Options(options ? options : ""));
+	}
+	catch (...) {
+		return NULL;
+	}
+}
+
+void gesture_engine_destroy(gesture_engine* engine)
+{
+	delete engine;
+}
+
+int gesture_engine_process(gesture_engine* engine, const unsigned char* bgr, int width, int height, size_t stride, gesture_result* result)
+{
+	if (!engine || !result) {
+		return -1;
+	}
+	try {
+		engine->error.clear();
+		if (!engine->engine.process(bgr, width, height, stride, engine->result)) {
+			engine->error = "invalid image buffer";
+			return -1;
+		}
+		const HandResult& hand = engine->result.hand;
+		copyPoints(engine->result.fingertips, engine->fingertips);
+		copyPoints(engine->result.hull, engine->hull);
+		result->found = hand.found ? 1 : 0;
+		result->gesture = (int)hand.gesture;
+		result->fingers = hand.fingers;
+		result->x = hand.bbox.x;
+		result->y = hand.bbox.y;
+		result->width = hand.bbox.width;
+		result->height = hand.bbox.height;
+		result->area = hand.area;
+		result->fingertips = engine->fingertips.empty() ? NULL : &engine->fingertips[0];
+		result->fingertip_count = (int)engine->fingertips.size();
+		result->hull = engine->hull.empty() ? NULL : &engine->hull[0];
+		result->hull_count = (int)engine->hull.size();
+		return 0;
+	}
+	catch (const exception& e) {
+		engine->error = e.what();
+	}
+	catch (...) {
+		engine->error = "unknown error";
+	}
+	return -1;
+}
+
+int gesture_engine_draw(gesture_engine* engine, unsigned char* bgr, int width, int height, size_t stride)
+{
+	if (!engine) {
+		return -1;
+	}
+	try {
+		engine->error.clear();
+		if (!engine->engine.draw(bgr, width, height, stride)) {
+			engine->error = "invalid image buffer";
+			return -1;
+		}
+		return 0;
+	}
+	catch (const exception& e) {
+		engine->error = e.what();
+	}
+	catch (...) {
+		engine->error = "unknown error";
+	}
+	return -1;
+}
+
+const char* gesture_engine_last_error(const gesture_engine* engine)
+{
+	return engine ? engine->error.c_str() : "no engine";
+}
+
+const char* gesture_name(int gesture)
+{
+	return gestureName((Gesture)gesture);
+}
@@ -0,0 +1,105 @@
+#ifndef GESTURE_C_API_H
+#define GESTURE_C_API_H
+
+#include <stddef.h>
+
+/**
+GestureCApi.h
+
+C interface to GestureEngine, for programs that embed the hand analysis in-process. An engine is an opaque handle;
+each one keeps its own state, so different engines can be used from different threads at once (one thread per
+engine at a time). Functions that can fail return 0 on success and -1 on error, with the reason available from
+gesture_engine_last_error. No C++ exception crosses this interface.
+*/
+
+#if defined(_WIN32) && defined(GESTURE_SHARED)
+#ifdef GESTURE_BUILDING
+#define GESTURE_API __declspec(dllexport)
+#else
+#define GESTURE_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define GESTURE_API __attribute__((visibility("default")))
+#else
+#define GESTURE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gesture_engine gesture_engine;
+
+typedef struct gesture_point {
+	int x;
+	int y;
+} gesture_point;
+
+/**
+What the engine found in one image. The point arrays belong to the engine and stay valid until its next
+gesture_engine_process call or its destruction
+*/
+typedef struct gesture_result {
+	int found;							/* 0 when no hand was found; the fields below are then empty */
+	int gesture;						/* 0 none, 1 rock, 2 scissor, 3 paper (see gesture_name) */
+	int fingers;
+	int x, y, width, height;			/* bounding box of the hand */
+	double area;						/* area of the hand contour */
+	const gesture_point* fingertips;
+	int fingertip_count;
+	const gesture_point* hull;			/* convex hull of the hand */
+	int hull_count;
+} gesture_result;
+
+/**
+Function that creates an engine, returns NULL on failure
+@param options Switches as on the lab command line, separated by spaces (e.g. "skin=ycrcb track=1"), or NULL for the defaults
+*/
+GESTURE_API gesture_engine* gesture_engine_create(const char* options);
+
+/**
+Destroys an engine; NULL is ignored
+@param engine The engine
+*/
+GESTURE_API void gesture_engine_destroy(gesture_engine* engine);
+
+/**
+Function that analyses one BGR image the caller owns; the pixels are read in place, not copied
+@param engine The engine
+@param bgr Pointer to the first pixel, 3 bytes per pixel in B, G, R order
+@param width Width in pixels
+@param height Height in pixels
+@param stride Bytes from the start of one row to the start of the next (at least 3 * width)
+@param result Receives the result
+*/
+GESTURE_API int gesture_engine_process(gesture_engine* engine, const unsigned char* bgr, int width, int height, size_t stride,
+	gesture_result* result);
+
+/**
+Function that draws the overlays of the last gesture_engine_process call (bounding box, hull, fingertips) on an image
+@param engine The engine
+@param bgr Pointer to the first pixel of the image to draw on, 3 bytes per pixel
+@param width Width in pixels
+@param height Height in pixels
+@param stride Bytes from the start of one row to the start of the next
+*/
+GESTURE_API int gesture_engine_draw(gesture_engine* engine, unsigned char* bgr, int width, int height, size_t stride);
+
+/**
+Function that returns the reason of the last failure of the engine, or the configuration messages after
+gesture_engine_create; empty when there is none. Valid until the next call on the engine
+@param engine The engine
+*/
+GESTURE_API const char* gesture_engine_last_error(const gesture_engine* engine);
+
+/**
+Function that returns the lower-case name of a gesture ("none", "rock", "scissor" or "paper")
+@param gesture The gesture number of a gesture_result
+*/
+GESTURE_API const char* gesture_name(int gesture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,88 @@
+#include "GestureEngine.h"
+
+#include "opencv2/highgui/highgui.hpp"
+
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+//Function that sets up the hand analysis from the command line switches
+void myConfigureHand(const Options& opts, HandScratch& scratch, ostream& messages) {
+	scratch.thresh = opts.getInt("thresh", scratch.thresh);
+	// track=1 restricts the analysis to a window around the previous hand, with a full-frame scan every refresh=N frames
+	scratch.tracking = opts.getInt("track", 0) != 0;
+	scratch.tracker = RoiTracker(opts.getInt("refresh", 30));
+	// scale=2|4 finds the hand on a 1/2 or 1/4 frame and refines only its bounding box at full resolution;
+	// budget=MS picks the scale (up to max_scale=N) so that the analysis of a frame stays under MS milliseconds
+	scratch.scaler = ScaleController(opts.getDouble("budget", 0), opts.getInt("scale", 1), opts.getInt("max_scale", 4));
+	// frames without a square of gate=N pixels (0: no gate) that is at least gate_density=F skin are reported as no hand
+	scratch.gate = SkinGate(opts.getInt("gate", 32), opts.getDouble("gate_density", 0.5));
+	// skin=rgb|ycrcb|hsv picks a built-in skin color model; skin=histogram trains one from skin_train=IMAGE,
+	// labelled by skin_train_mask=MASK (white = skin) if given, with the decision threshold skin_theta=T
+	string skinName = opts.get("skin", "rgb");
+	if (skinName == "histogram")
+	{
+		Mat samples = imread(opts.get("skin_train"));
+		Mat labels = opts.has("skin_train_mask") ? imread(opts.get("skin_train_mask"), 0) : Mat();
+		if (samples.empty() || (opts.has("skin_train_mask") && labels.size() != samples.size()))
+		{
+			messages << "Cannot read the skin training image, using rgb" << endl;
+		}
+		else
+		{
+			scratch.skinModel = SkinModel::fromSamples(samples, labels, opts.getDouble("skin_theta", 1.0));
+		}
+	}
+	else if (!SkinModel::byName(skinName, scratch.skinModel))
+	{
+		messages << "Unknown skin model " << skinName << ", using rgb" << endl;
+	}
+}
+
+GestureEngine::GestureEngine()
+{
+	m_scratch.draw = false;
+}
+
+GestureEngine::GestureEngine(const Options& opts)
+{
+	stringstream messages;
+	myConfigureHand(opts, m_scratch, messages);
+	m_messages = messages.str();
+	// overlays are drawn on request only
+	m_scratch.draw = false;
+}
+
+bool GestureEngine::process(const unsigned char* bgr, int width, int height, size_t stride, GestureResult& result)
+{
+	if (!bgr || width <= 0 || height <= 0 || stride < (size_t)width * 3)
+	{
+		return false;
+	}
+	// a header on the caller's pixels, no copy; with drawing off the analysis does not write to it
+	Mat frame(height, width, CV_8UC3, const_cast<unsigned char*>(bgr), stride);
+	myAnalyzeFrame(frame, m_skin, m_scratch, m_last);
+
+	result.hand = m_last;
+	result.fingertips.clear();
+	result.hull.clear();
+	if (m_last.found)
+	{
+		result.fingertips.assign(m_scratch.fingerPoints.tips.begin(), m_scratch.fingerPoints.tips.end());
+		result.hull.assign(m_scratch.hull.points.begin(), m_scratch.hull.points.end());
+	}
+	return true;
+}
+
+bool GestureEngine::draw(unsigned char* bgr, int width, int height, size_t stride) const
+{
+	if (!bgr || width <= 0 || height <= 0 || stride < (size_t)width * 3)
+	{
+		return false;
+	}
+	Mat frame(height, width, CV_8UC3, bgr, stride);
+	Mat noSkin;
+	myDrawHand(frame, noSkin, m_scratch, m_last);
+	return true;
+}
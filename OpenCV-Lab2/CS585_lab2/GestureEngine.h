@@ -0,0 +1,88 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "HandAnalysis.h"
+#include "Options.h"
+
+/**
+GestureEngine.h
+
+The hand analysis as a library: a GestureEngine holds all the state of one stream (skin model, tracker, scale
+controller, scratch buffers), so several engines can run on different threads at once. It reads a BGR image the
+caller owns, without copying it, and returns the gesture, the finger count, the fingertips, the hull and the bounding
+box. Drawing the overlays is a separate, optional call. GestureCApi.h exposes the same engine to C callers.
+*/
+
+/**
+What the engine found in one image
+*/
+struct GestureResult {
+	HandResult hand;						// gesture, finger count, bounding box, contour area and stage timings
+	std::vector<cv::Point> fingertips;		// fingertip points, in image coordinates
+	std::vector<cv::Point> hull;			// convex hull of the hand, in image coordinates
+};
+
+/**
+Function that sets up the hand analysis from the command line switches: skin=, skin_train=, skin_train_mask=, skin_theta=,
+track=, refresh=, scale=, budget=, max_scale=, gate=, gate_density= and thresh=
+@param opts The switches
+@param scratch The analysis state to configure
+@param messages Receives a line for every switch that could not be applied (the default is used instead)
+*/
+void myConfigureHand(const Options& opts, HandScratch& scratch, std::ostream& messages);
+
+class GestureEngine {
+public:
+	/**
+	Creates an engine with the default settings (RGB skin rule, full-frame analysis)
+	*/
+	GestureEngine();
+
+	/**
+	Creates an engine configured by the same switches as the lab executable (see myConfigureHand)
+	@param opts The switches
+	*/
+	explicit GestureEngine(const Options& opts);
+
+	/**
+	Function that analyses one image, returns false if the buffer description is not valid. The image is only read
+	@param bgr Pointer to the first pixel, 3 bytes per pixel in B, G, R order
+	@param width Width in pixels
+	@param height Height in pixels
+	@param stride Bytes from the start of one row to the start of the next (at least 3 * width)
+	@param result Receives the result; its vectors keep their capacity when it is reused
+	*/
+	bool process(const unsigned char* bgr, int width, int height, size_t stride, GestureResult& result);
+
+	/**
+	Function that draws the overlays of the last process() call on an image of the same size (usually the same buffer),
+	returns false if the buffer description is not valid
+	@param bgr Pointer to the first pixel, 3 bytes per pixel
+	@param width Width in pixels
+	@param height Height in pixels
+	@param stride Bytes from the start of one row to the start of the next
+	*/
+	bool draw(unsigned char* bgr, int width, int height, size_t stride) const;
+
+	/**
+	Function that returns the skin mask of the last process() call
+	*/
+	const cv::Mat& skinMask() const { return m_skin; }
+
+	/**
+	Function that returns the messages of the configuration, one per line (empty when every switch was applied)
+	*/
+	const std::string& messages() const { return m_messages; }
+
+private:
+	HandScratch m_scratch;
+	HandResult m_last;
+	cv::Mat m_skin;
+	std::string m_messages;
+};
@@ -0,0 +1,201 @@
+#include "GestureEvents.h"
+
+#include "StageProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+
+const char* gestureEventName(GestureEventType type)
+{
+	switch (type) {
+	case EVENT_SWIPE_LEFT:
+		return "swipe_left";
+	case EVENT_SWIPE_RIGHT:
+		return "swipe_right";
+	case EVENT_SWIPE_UP:
+		return "swipe_up";
+	case EVENT_SWIPE_DOWN:
+		return "swipe_down";
+	case EVENT_WAVE:
+		return "wave";
+	default:
+		return "gesture";
+	}
+}
+
+GestureStateMachine::GestureStateMachine(const TemporalConfig& config, int queueCapacity)
+	: m_config(config), m_ring(std::max(1, std::max(config.voteWindow, config.trackWindow))), m_head(-1), m_count(0),
+	m_stable(GESTURE_NONE), m_cooldown(0), m_tracked(0), m_queue(queueCapacity)
+{
+}
+
+void GestureStateMachine::reset()
+{
+	m_head = -1;
+	m_count = 0;
+	m_stable = GESTURE_NONE;
+	m_cooldown = 0;
+	m_tracked = 0;
+}
+
+//The sample of age frames ago (0 = newest)
+const GestureStateMachine::Sample& GestureStateMachine::sample(int age) const
+{
+	int n = (int)m_ring.size();
+	return m_ring[(m_head - age + n) % n];
+}
+
+void GestureStateMachine::update(unsigned long long frame, long long captureTick, const HandResult& hand, Size frameSize, double motionShare)
+{
+	m_head = (m_head + 1) % (int)m_ring.size();
+	m_count = std::min(m_count + 1, (int)m_ring.size());
+	Sample& s = m_ring[m_head];
+	s.found = hand.found;
+	s.gesture = hand.found ? hand.gesture : GESTURE_NONE;
+	s.center = hand.center;
+	s.motion = motionShare;
+
+	detectStatic(frame, captureTick);
+	// the trajectory of a dynamic gesture starts after the cooldown, so no frame counts towards two of them
+	if (m_cooldown > 0) {
+		m_cooldown--;
+		m_tracked = 0;
+	}
+	else {
+		m_tracked = hand.found ? m_tracked + 1 : 0;
+		detectDynamic(frame, captureTick, frameSize);
+	}
+}
+
+//Vote over the last voteWindow frames; the stable gesture changes only when another label has enterVotes of them
+void GestureStateMachine::detectStatic(unsigned long long frame, long long captureTick)
+{
+	int window = std::min(m_count, m_config.voteWindow);
+	int votes[GESTURE_PAPER + 1] = { 0 };
+	for (int age = 0; age < window; age++) {
+		votes[sample(age).gesture]++;
+	}
+	int best = GESTURE_NONE;
+	for (int g = GESTURE_NONE + 1; g <= GESTURE_PAPER; g++) {
+		if (votes[g] > votes[best]) {
+			best = g;
+		}
+	}
+	if (best != m_stable && votes[best] >= std::min(m_config.enterVotes, m_config.voteWindow)) {
+		Gesture previous = m_stable;
+		m_stable = (Gesture)best;
+		emit(EVENT_GESTURE, previous, frame, captureTick, (double)votes[best] / window);
+	}
+}
+
+//Swipes and waves from the hand center over the last trackWindow frames; the hand has to be found in all of them
+void GestureStateMachine::detectDynamic(unsigned long long frame, long long captureTick, Size frameSize)
+{
+	int window = m_config.trackWindow;
+	if (m_tracked < window || window < 2) {
+		return;
+	}
+	int moving = 0, measured = 0;
+	for (int age = 0; age < window; age++) {
+		const Sample& s = sample(age);
+		if (s.motion >= 0) {
+			measured++;
+			moving += s.motion >= m_config.minMotion;
+		}
+	}
+	// with motion measured, most of the frames have to show motion around the hand
+	if (measured > 0 && moving * 2 < measured) {
+		return;
+	}
+	double confidence = measured > 0 ? (double)moving / measured : 1.0;
+
+	// wave: count the reversals of the horizontal direction between excursions of at least waveAmplitude
+	double amplitude = m_config.waveAmplitude * frameSize.width;
+	int reversals = 0;
+	int direction = 0;
+	float extreme = sample(window - 1).center.x;
+	for (int age = window - 2; age >= 0; age--) {
+		float x = sample(age).center.x;
+		if (direction >= 0 && x > extreme) {
+			extreme = x;
+			direction = 1;
+		}
+		else if (direction <= 0 && x < extreme) {
+			extreme = x;
+			direction = -1;
+		}
+		else if (std::fabs(x - extreme) >= amplitude) {
+			// turned back far enough: the excursion in the old direction is over
+			reversals++;
+			direction = -direction;
+			extreme = x;
+		}
+	}
+	if (reversals >= m_config.waveReversals) {
+		emit(EVENT_WAVE, m_stable, frame, captureTick, confidence);
+		m_cooldown = m_config.cooldown;
+		m_tracked = 0;
+		return;
+	}
+
+	// swipe: a large displacement, mostly along one axis
+	Point2f d = sample(0).center - sample(window - 1).center;
+	double dx = d.x, dy = d.y;
+	if (std::fabs(dx) >= m_config.swipeDistance * frameSize.width && std::fabs(dx) > 2 * std::fabs(dy)) {
+		emit(dx < 0 ? EVENT_SWIPE_LEFT : EVENT_SWIPE_RIGHT, m_stable, frame, captureTick, confidence);
+		m_cooldown = m_config.cooldown;
+		m_tracked = 0;
+	}
+	else if (std::fabs(dy) >= m_config.swipeDistance * frameSize.height && std::fabs(dy) > 2 * std::fabs(dx)) {
+		emit(dy < 0 ? EVENT_SWIPE_UP : EVENT_SWIPE_DOWN, m_stable, frame, captureTick, confidence);
+		m_cooldown = m_config.cooldown;
+		m_tracked = 0;
+	}
+}
+
+void GestureStateMachine::emit(GestureEventType type, Gesture previous, unsigned long long frame, long long captureTick, double confidence)
+{
+	GestureEvent& e = m_spare;
+	e.type = type;
+	e.gesture = m_stable;
+	e.previous = previous;
+	e.frame = frame;
+	e.confidence = confidence;
+	e.latencyMs = (getTickCount() - captureTick) * 1000.0 / getTickFrequency();
+	StageProfiler::record(PROFILE_EVENT, e.latencyMs);
+	if (m_callback) {
+		m_callback(e);
+	}
+	m_queue.pushDropOldest(e);
+}
+
+double myMotionShare(const Mat& motionEnergy, const Rect& box)
+{
+	Rect r = box & Rect(0, 0, motionEnergy.cols, motionEnergy.rows);
+	if (r.area() == 0) {
+		return 0;
+	}
+	// Documentation for countNonZero: http://docs.opencv.org/modules/core/doc/operations_on_arrays.html#countnonzero
+	return (double)countNonZero(motionEnergy(r)) / r.area();
+}
+
+void myConfigureEvents(const Options& opts, TemporalConfig& config)
+{
+	config.voteWindow = std::max(1, opts.getInt("vote_window", config.voteWindow));
+	config.enterVotes = std::max(1, opts.getInt("vote_enter", config.enterVotes));
+	config.trackWindow = std::max(2, opts.getInt("track_window", config.trackWindow));
+	config.swipeDistance = opts.getDouble("swipe", config.swipeDistance);
+	config.waveAmplitude = opts.getDouble("wave", config.waveAmplitude);
+	config.waveReversals = std::max(1, opts.getInt("wave_reversals", config.waveReversals));
+	config.minMotion = opts.getDouble("min_motion", config.minMotion);
+	config.cooldown = std::max(0, opts.getInt("cooldown", config.cooldown));
+}
+
+void myWriteEvent(std::ostream& out, const GestureEvent& event)
+{
+	out << "{\"frame\":" << event.frame << ",\"event\":\"" << gestureEventName(event.type) << "\",\"gesture\":\"" << gestureName(event.gesture)
+		<< "\",\"previous\":\"" << gestureName(event.previous) << "\",\"confidence\":" << event.confidence
+		<< ",\"latency_ms\":" << event.latencyMs << "}\n";
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include "BoundedRing.h"
+#include "HandAnalysis.h"
+#include "Options.h"
+
+/**
+GestureEvents.h
+
+Temporal layer over the per-frame results of myAnalyzeFrame. The last frames are kept in a ring; the static gesture
+(rock, scissor, paper or none) is the label that wins a vote over a window of frames, and it only changes when the
+new label holds a qualified majority (hysteresis), so single-frame flicker never reaches the consumers.
+Dynamic gestures come from the trajectory of the hand center: a swipe is a large, mostly straight displacement,
+a wave a series of left-right reversals, both gated by the motion energy around the hand when it is available.
+Every change is emitted once, as an event with the time from the capture of the deciding frame to the emission,
+through a callback and a queue that another thread can drain.
+*/
+
+/**
+Kind of event
+*/
+enum GestureEventType {
+	EVENT_GESTURE,		// the static gesture changed
+	EVENT_SWIPE_LEFT,	// the hand moved left (in image coordinates)
+	EVENT_SWIPE_RIGHT,
+	EVENT_SWIPE_UP,
+	EVENT_SWIPE_DOWN,
+	EVENT_WAVE			// the hand moved left and right several times
+};
+
+/**
+Function that returns the lower-case name of an event type ("gesture", "swipe_left", ...)
+@param type The event type
+*/
+const char* gestureEventName(GestureEventType type);
+
+/**
+One change of the recognised gesture
+*/
+struct GestureEvent {
+	GestureEventType type;
+	Gesture gesture;				// static gesture after the event (the current one for dynamic events)
+	Gesture previous;				// static gesture before the event
+	unsigned long long frame;		// index of the frame that decided the event
+	double confidence;				// share of the votes (static) or of the frames in motion (dynamic), in [0, 1]
+	double latencyMs;				// from the capture of the deciding frame to the emission of the event
+
+	GestureEvent() : type(EVENT_GESTURE), gesture(GESTURE_NONE), previous(GESTURE_NONE), frame(0), confidence(0), latencyMs(0) {}
+};
+
+/**
+Windows and thresholds of the temporal layer
+*/
+struct TemporalConfig {
+	int voteWindow;			// frames in the static gesture vote
+	int enterVotes;			// votes a label needs in the window to become the stable gesture
+	int trackWindow;		// frames of hand-center trajectory used for the dynamic gestures
+	double swipeDistance;	// displacement of a swipe, as a fraction of the frame width (or height)
+	double waveAmplitude;	// smallest left-right excursion that counts towards a wave, as a fraction of the frame width
+	int waveReversals;		// direction reversals that make a wave
+	double minMotion;		// share of moving pixels in the hand box needed for a dynamic gesture (when motion is measured)
+	int cooldown;			// frames ignored after a dynamic gesture before the trajectory of the next one starts
+
+	TemporalConfig() : voteWindow(7), enterVotes(5), trackWindow(15), swipeDistance(0.25), waveAmplitude(0.06),
+		waveReversals(3), minMotion(0.05), cooldown(5) {}
+};
+
+class GestureStateMachine {
+public:
+	typedef std::function<void(const GestureEvent&)> EventFn;
+
+	/**
+	@param config Windows and thresholds
+	@param queueCapacity Capacity of the event queue; the oldest events are dropped when nobody drains it
+	*/
+	explicit GestureStateMachine(const TemporalConfig& config = TemporalConfig(), int queueCapacity = 64);
+
+	/**
+	Sets a function called (on the thread that calls update) for every event
+	@param callback The function, or an empty one for none
+	*/
+	void setCallback(EventFn callback) { m_callback = callback; }
+
+	/**
+	Adds the result of one frame and emits the events it decides
+	@param frame Index of the frame
+	@param captureTick cv::getTickCount() when the frame was captured, for the event latency
+	@param hand The result of myAnalyzeFrame for the frame
+	@param frameSize Size of the frame
+	@param motionShare Share of moving pixels in the hand box (see myMotionShare), negative when motion is not measured
+	*/
+	void update(unsigned long long frame, long long captureTick, const HandResult& hand, cv::Size frameSize, double motionShare = -1);
+
+	/**
+	Function that takes the oldest queued event, returns false if there is none. One thread may drain the queue
+	while another calls update
+	@param event Receives the event
+	*/
+	bool nextEvent(GestureEvent& event) { return m_queue.tryPop(event); }
+
+	/**
+	Function that returns the current stable gesture
+	*/
+	Gesture stable() const { return m_stable; }
+
+	/**
+	Forgets the history; the stable gesture goes back to none without an event
+	*/
+	void reset();
+
+private:
+	struct Sample {
+		Gesture gesture;
+		bool found;
+		cv::Point2f center;
+		double motion;
+	};
+
+	void emit(GestureEventType type, Gesture previous, unsigned long long frame, long long captureTick, double confidence);
+	void detectStatic(unsigned long long frame, long long captureTick);
+	void detectDynamic(unsigned long long frame, long long captureTick, cv::Size frameSize);
+	const Sample& sample(int age) const;
+
+	TemporalConfig m_config;
+	std::vector<Sample> m_ring;	// the last max(voteWindow, trackWindow) frames
+	int m_head;					// slot of the newest sample
+	int m_count;				// samples in the ring
+	Gesture m_stable;
+	int m_cooldown;
+	int m_tracked;				// frames in a row with a hand since the cooldown ended
+	EventFn m_callback;
+	BoundedRing<GestureEvent> m_queue;
+	GestureEvent m_spare;		// passed to the queue, which recycles the evicted contents into it
+};
+
+/**
+Function that returns the share of non-zero pixels of a mask inside a box, 0 for an empty box
+@param motionEnergy The motion energy (or any binary CV_8UC1 mask)
+@param box The hand bounding box
+*/
+double myMotionShare(const cv::Mat& motionEnergy, const cv::Rect& box);
+
+/**
+Function that reads the temporal settings from the command line switches: vote_window=, vote_enter=, track_window=,
+swipe=, wave=, wave_reversals=, min_motion= and cooldown=
+@param opts The switches
+@param config Receives the settings; the ones not given keep their value
+*/
+void myConfigureEvents(const Options& opts, TemporalConfig& config);
+
+/**
+Writes an event as one JSON line
+@param out The destination stream
+@param event The event
+*/
+void myWriteEvent(std::ostream& out, const GestureEvent& event);
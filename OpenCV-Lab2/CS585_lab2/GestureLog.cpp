@@ -0,0 +1,56 @@
+#include "GestureLog.h"
+
+#include <iomanip>
+
+//Function that tells whether a string ends with the given suffix
+static bool endsWith(const std::string& s, const std::string& suffix)
+{
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+GestureLog::GestureLog() : m_format(CSV)
+{
+}
+
+GestureLog::Format GestureLog::formatFor(const std::string& path)
+{
+	return endsWith(path, ".jsonl") || endsWith(path, ".json") ? JSON_LINES : CSV;
+}
+
+bool GestureLog::open(const std::string& path)
+{
+	m_format = formatFor(path);
+	m_out.open(path.c_str(), std::ios::out | std::ios::trunc);
+	if (!m_out.is_open()) {
+		return false;
+	}
+	m_out << std::fixed << std::setprecision(3);
+	if (m_format == CSV) {
+		m_out << "frame,gesture,fingers,x,y,width,height,area,skin_ms,threshold_ms,contours_ms,hull_ms,classify_ms\n";
+	}
+	return true;
+}
+
+void GestureLog::write(unsigned long long frame, const HandResult& hand)
+{
+	const StageTimes& t = hand.times;
+	if (m_format == CSV) {
+		m_out << frame << ',' << gestureName(hand.gesture) << ',' << hand.fingers << ','
+			<< hand.bbox.x << ',' << hand.bbox.y << ',' << hand.bbox.width << ',' << hand.bbox.height << ',' << hand.area << ','
+			<< t.skin << ',' << t.threshold << ',' << t.contours << ',' << t.hull << ',' << t.classify << '\n';
+	}
+	else {
+		m_out << "{\"frame\":" << frame << ",\"gesture\":\"" << gestureName(hand.gesture) << "\",\"fingers\":" << hand.fingers
+			<< ",\"bbox\":[" << hand.bbox.x << ',' << hand.bbox.y << ',' << hand.bbox.width << ',' << hand.bbox.height << ']'
+			<< ",\"area\":" << hand.area
+			<< ",\"ms\":{\"skin\":" << t.skin << ",\"threshold\":" << t.threshold << ",\"contours\":" << t.contours
+			<< ",\"hull\":" << t.hull << ",\"classify\":" << t.classify << "}}\n";
+	}
+}
+
+void GestureLog::close()
+{
+	if (m_out.is_open()) {
+		m_out.close();
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include "HandAnalysis.h"
+
+/**
+GestureLog.h
+
+Per-frame output of the headless mode: one record per analysed frame with the gesture, the finger count,
+the bounding box and area of the hand contour and the time spent in each analysis stage.
+Records are written as CSV (with a header line) or as JSON Lines (one object per line).
+*/
+class GestureLog {
+public:
+	enum Format {
+		CSV,
+		JSON_LINES
+	};
+
+	GestureLog();
+
+	/**
+	Function that creates (or truncates) the output file, returns false if it cannot be opened.
+	The format is JSON Lines when the name ends in ".jsonl" or ".json", CSV otherwise
+	@param path Name of the output file
+	*/
+	bool open(const std::string& path);
+
+	/**
+	Function that appends the record of one frame
+	@param frame Index of the frame in the source, starting at 0
+	@param hand What the analysis found in the frame
+	*/
+	void write(unsigned long long frame, const HandResult& hand);
+
+	/**
+	Flushes and closes the file
+	*/
+	void close();
+
+	/**
+	Function that returns the format used for a file name
+	@param path Name of the output file
+	*/
+	static Format formatFor(const std::string& path);
+
+private:
+	std::ofstream m_out;
+	Format m_format;
+};
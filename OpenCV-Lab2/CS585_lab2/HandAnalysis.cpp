@@ -0,0 +1,402 @@
+#include "HandAnalysis.h"
+#include "ImageKernels.h"
+#include "StageProfiler.h"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+//Function that returns the lower-case name of a gesture
+const char* gestureName(Gesture gesture)
+{
+	switch (gesture) {
+	case GESTURE_ROCK:
+		return "rock";
+	case GESTURE_SCISSOR:
+		return "scissor";
+	case GESTURE_PAPER:
+		return "paper";
+	default:
+		return "none";
+	}
+}
+
+//Function that returns the index of the contour with the largest area
+int myLargestContour(const vector<vector<Point> >& contours, double& area)
+{
+	int maxind = -1;
+	area = 0;
+	for (int i = 0; i < (int)contours.size(); i++)
+	{
+		// Documentation on contourArea: http://docs.opencv.org/modules/imgproc/doc/structural_analysis_and_shape_descriptors.html#
+		double a = contourArea(contours[i]);
+		if (maxind < 0 || a > area) {
+			area = a;
+			maxind = i;
+		}
+	}
+	return maxind;
+}
+
+//Cross product of (a - o) and (b - o); positive when o -> a -> b turns counter-clockwise
+static inline long long cross(const Point& o, const Point& a, const Point& b)
+{
+	return (long long)(a.x - o.x) * (b.y - o.y) - (long long)(a.y - o.y) * (b.x - o.x);
+}
+
+//Function that computes the convex hull of a contour, then its convexity defects
+void myConvexHullDefects(const vector<Point>& contour, HandHull& hull)
+{
+	vector<int>& h = hull.indices;
+	h.clear();
+	hull.points.clear();
+	hull.defects.clear();
+
+	int n = (int)contour.size();
+	if (n < 3) {
+		for (int i = 0; i < n; i++) {
+			h.push_back(i);
+			hull.points.push_back(contour[i]);
+		}
+		return;
+	}
+
+	// Monotone chain: sort the points by x (then y), build the lower hull left to right and the upper hull right to left,
+	// dropping every point that does not make a strict left turn
+	vector<int>& order = hull.order;
+	order.resize(n);
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	sort(order.begin(), order.end(), [&contour](int a, int b) {
+		return contour[a].x < contour[b].x || (contour[a].x == contour[b].x && contour[a].y < contour[b].y);
+	});
+
+	h.resize(2 * n);
+	int k = 0;
+	for (int i = 0; i < n; i++) {
+		while (k >= 2 && cross(contour[h[k - 2]], contour[h[k - 1]], contour[order[i]]) <= 0) {
+			k--;
+		}
+		h[k++] = order[i];
+	}
+	for (int i = n - 2, lower = k + 1; i >= 0; i--) {
+		while (k >= lower && cross(contour[h[k - 2]], contour[h[k - 1]], contour[order[i]]) <= 0) {
+			k--;
+		}
+		h[k++] = order[i];
+	}
+	// the last point is the first one again
+	h.resize(max(1, k - 1));
+
+	// For a contour the hull vertices appear in the same cyclic order along the contour as around the hull,
+	// so sorting the indices gives a valid polygon and lets the defect sweep walk the contour forward
+	sort(h.begin(), h.end());
+	for (size_t i = 0; i < h.size(); i++) {
+		hull.points.push_back(contour[h[i]]);
+	}
+
+	int m = (int)h.size();
+	if (m <= 3) {
+		return;
+	}
+
+	// Defects: for each hull edge, the contour point between its two ends that lies farthest from the edge
+	for (int e = 0; e < m; e++) {
+		int start = h[e];
+		int end = h[(e + 1) % m];
+		const Point& ps = contour[start];
+		const Point& pe = contour[end];
+		double dx0 = pe.x - ps.x;
+		double dy0 = pe.y - ps.y;
+		double len = sqrt(dx0 * dx0 + dy0 * dy0);
+		if (len == 0) {
+			continue;
+		}
+
+		double depth = 0;
+		int farthest = -1;
+		for (int j = start + 1 == n ? 0 : start + 1; j != end; j = j + 1 == n ? 0 : j + 1) {
+			double d = fabs(-dy0 * (contour[j].x - ps.x) + dx0 * (contour[j].y - ps.y));
+			if (d > depth) {
+				depth = d;
+				farthest = j;
+			}
+		}
+		if (farthest >= 0) {
+			hull.defects.push_back(Vec4i(start, end, farthest, cvRound(depth / len * 256)));
+		}
+	}
+}
+
+//Function that counts the fingers from the convexity defects and decides rock, paper, scissors
+Gesture myCountFingers(const vector<Vec4i>& Defects, const vector<Point>& contour, HandFingers& hand)
+{
+	hand.tips.clear();
+	hand.starts.clear();
+
+	// find the centorid of the hand 
+	minEnclosingCircle(contour, hand.center, hand.radius);
+
+	for (int i = 0; i < Defects.size(); i++) {
+
+		//extracting the start point and the depth from the Defects
+		Point ptStart(contour[Defects[i].val[0]]);
+		double depth = static_cast<double>(Defects[i].val[3]) / 256;
+		hand.starts.push_back(ptStart);
+
+		//if the depth > 11 and the start point is higher than the center, count that as a finger
+		if (depth>11 && ptStart.y<hand.center.y) {
+			hand.tips.push_back(ptStart);
+		}
+	}
+
+	//index: if number if fingers detected: (0,1):Rock, (2,3):Scussor, (>3):Paper
+	int fingers = (int)hand.tips.size();
+	if (fingers >1 && fingers <= 3) {
+		return GESTURE_SCISSOR;
+	}
+	else if (fingers <= 1) {
+		return GESTURE_ROCK;
+	}
+	else {
+		return GESTURE_PAPER;
+	}
+}
+
+//Function that draws the hand center, the defect start points and the fingertips
+void myDrawFingers(Mat& frame, const HandFingers& hand)
+{
+	circle(frame, hand.center, 10, CV_RGB(0, 0, 255), 2, 8);
+	for (size_t i = 0; i < hand.starts.size(); i++) {
+		circle(frame, hand.starts[i], 5, CV_RGB(255, 0, 0), 2, 8);
+	}
+	for (size_t i = 0; i < hand.tips.size(); i++) {
+		circle(frame, hand.tips[i], 4, CV_RGB(255, 0, 0), 4);
+	}
+}
+
+//Function that determines rock, paper, scissors
+Gesture condefects(const vector<Vec4i>& Defects, const vector<Point>& contour, Mat &frame, bool draw, int& fingers)
+{
+	HandFingers hand;
+	Gesture gesture = myCountFingers(Defects, contour, hand);
+	fingers = (int)hand.tips.size();
+	if (draw) {
+		myDrawFingers(frame, hand);
+	}
+	return gesture;
+}
+
+//Function that draws the analysed window, bounding box, hull, hand center and fingertips
+static void drawHand(Mat& frame, Mat& SkinframeDest, const Rect& window, bool partial, const vector<Point>& hull,
+	const HandFingers& fingers, const HandResult& result)
+{
+	// Documentation for drawing rectangle: http://docs.opencv.org/modules/core/doc/drawing_functions.html
+	if (partial) {
+		rectangle(frame, window, Scalar(0, 255, 255), 1, 8, 0);
+	}
+	rectangle(frame, result.bbox, Scalar(0, 255, 0), 1, 8, 0);
+	polylines(frame, hull, true, Scalar(0, 0, 255), 2, 8);
+	if (!SkinframeDest.empty()) {
+		rectangle(SkinframeDest, result.bbox, Scalar(255, 255, 255), 1, 8, 0);
+		polylines(SkinframeDest, hull, true, Scalar(255, 0, 255), 2, 8);
+	}
+	myDrawFingers(frame, fingers);
+}
+
+//Function that draws the overlays of the last analysis
+void myDrawHand(Mat& frame, Mat& SkinframeDest, const HandScratch& scratch, const HandResult& result)
+{
+	if (result.found) {
+		drawHand(frame, SkinframeDest, scratch.window, scratch.partial, scratch.hull.points, scratch.fingerPoints, result);
+	}
+}
+
+//Function that copies what the overlays of the last analysis need
+void myCaptureOverlay(const HandScratch& scratch, HandOverlay& overlay)
+{
+	// assign keeps the capacity of the vectors
+	overlay.window = scratch.window;
+	overlay.partial = scratch.partial;
+	overlay.hull.assign(scratch.hull.points.begin(), scratch.hull.points.end());
+	overlay.fingers.center = scratch.fingerPoints.center;
+	overlay.fingers.radius = scratch.fingerPoints.radius;
+	overlay.fingers.starts.assign(scratch.fingerPoints.starts.begin(), scratch.fingerPoints.starts.end());
+	overlay.fingers.tips.assign(scratch.fingerPoints.tips.begin(), scratch.fingerPoints.tips.end());
+	overlay.valid = true;
+}
+
+//Function that draws captured overlays
+void myDrawOverlay(Mat& frame, Mat& SkinframeDest, const HandOverlay& overlay, const HandResult& result)
+{
+	if (result.found && overlay.valid) {
+		drawHand(frame, SkinframeDest, overlay.window, overlay.partial, overlay.hull, overlay.fingers, result);
+	}
+}
+
+//Function that clears what an earlier frame left in a mask and records the new window
+void SkinWindows::prepare(Mat& mask, const Rect& newWindow, bool reallocated)
+{
+	Rect all(0, 0, mask.cols, mask.rows);
+	int slot = -1;
+	for (int i = 0; i < SLOTS; i++) {
+		if (data[i] == mask.data) {
+			slot = i;
+		}
+	}
+	if (newWindow == all) {
+		// every pixel is written
+	}
+	else if (slot < 0 || reallocated) {
+		mask.setTo(Scalar(0));
+	}
+	else if (!window[slot].empty()) {
+		mask(window[slot]).setTo(Scalar(0));
+	}
+	if (slot < 0) {
+		slot = next;
+		next = (next + 1) % SLOTS;
+		data[slot] = mask.data;
+	}
+	// the overlays drawn on the mask (hull lines 2 pixels wide) may spill just outside the window
+	window[slot] = newWindow.empty() ? Rect() : Rect(newWindow.x - 2, newWindow.y - 2, newWindow.width + 4, newWindow.height + 4) & all;
+}
+
+//Function that runs the hand analysis on one frame, at the working scale of scratch.scaler
+static void analyzeFrame(Mat& frame, Mat& SkinframeDest, HandScratch& scratch, HandResult& result) {
+	ScopedStageTimer skinTimer(PROFILE_SKIN, &result.times.skin);
+	// destination frame; a recycled buffer is only cleared where an earlier frame wrote outside this frame's window
+	const uchar* skinData = SkinframeDest.data;
+	SkinframeDest.create(frame.rows, frame.cols, CV_8UC1);
+	bool reallocated = SkinframeDest.data != skinData;
+
+	// the part of the frame to analyse: all of it, or in tracking mode the window predicted from the previous hand
+	Rect roi(0, 0, frame.cols, frame.rows);
+	bool partial = false;
+	if (scratch.tracking)
+	{
+		roi = scratch.tracker.searchWindow(frame.size());
+		partial = !scratch.tracker.lastWasFullScan();
+	}
+
+	// coarse-to-fine: find the hand blob on the window shrunk by the working scale, then analyse only its bounding box
+	// at full resolution. The skin timer then also covers the shrinking and the coarse blob search
+	int scale = scratch.scaler.scale();
+	result.scale = scale;
+	if (scale > 1)
+	{
+		// Documentation for resize: http://docs.opencv.org/modules/imgproc/doc/geometric_transformations.html#resize
+		Size small(max(1, roi.width / scale), max(1, roi.height / scale));
+		resize(frame(roi), scratch.smallFrame, small, 0, 0, INTER_AREA);
+		scratch.smallSkin.create(small, CV_8UC1);
+		mySkinDetect(scratch.smallFrame, scratch.smallSkin, scratch.skinModel, scratch.gate);
+		int coarse = scratch.gate.anyCandidate(scale) ? scratch.blobs.extract(scratch.smallSkin, scratch.thresh) : -1;
+		Rect window;
+		if (coarse >= 0)
+		{
+			// back to frame coordinates, with a margin of two coarse pixels for the outline lost by shrinking
+			Rect b = scratch.blobs.blobs()[coarse].bbox;
+			double fx = (double)roi.width / small.width, fy = (double)roi.height / small.height;
+			int mx = cvCeil(2 * fx), my = cvCeil(2 * fy);
+			window = Rect(roi.x + cvFloor(b.x * fx) - mx, roi.y + cvFloor(b.y * fy) - my,
+				cvCeil(b.width * fx) + 2 * mx, cvCeil(b.height * fy) + 2 * my) & roi;
+		}
+		// the skin outside the window is not computed at full resolution; no window at all when there is no hand
+		roi = window;
+		partial = true;
+	}
+	scratch.window = roi;
+	scratch.partial = partial;
+	// the skin outside the window is not computed this frame and must read 0
+	scratch.skinWindows.prepare(SkinframeDest, roi, reallocated);
+	Mat frameRoi = frame(roi);
+	Mat skinRoi = SkinframeDest(roi);
+
+	//----------------
+	//	b) Skin color detection
+	//----------------
+	// at full scale the skin pixels are also counted for the gate; the coarse pass has already been gated
+	bool gated = scale == 1 && scratch.gate.enabled();
+	if (!roi.empty())
+	{
+		if (gated)
+		{
+			mySkinDetect(frameRoi, skinRoi, scratch.skinModel, scratch.gate);
+		}
+		else
+		{
+			mySkinDetect(frameRoi, skinRoi, scratch.skinModel);
+		}
+	}
+	bool candidate = roi.empty() || !gated || scratch.gate.anyCandidate();
+	skinTimer.stop();
+	if (roi.empty() || !candidate)
+	{
+		// no region dense and large enough to be a hand: no blob, contour, hull or classification
+		if (scratch.tracking)
+		{
+			scratch.tracker.update(Rect());
+		}
+		return;
+	}
+
+	// Find the largest blob in one pass over the skin mask, thresholding it on the fly (pixels above scratch.thresh),
+	// instead of a threshold copy, findContours on every blob and contourArea on every contour.
+	// Only the outer contour of the largest blob is traced; the offset puts it back in frame coordinates
+	ScopedStageTimer contoursTimer(PROFILE_CONTOURS, &result.times.contours);
+	BlobExtractor& blobs = scratch.blobs;
+	int maxind = blobs.extract(skinRoi, scratch.thresh);
+	if (maxind < 0)
+	{
+		contoursTimer.stop();
+		if (scratch.tracking)
+		{
+			scratch.tracker.update(Rect());
+		}
+		return;
+	}
+	vector<Point>& contour = scratch.handContour;
+	blobs.traceOuterContour(skinRoi, maxind, contour, roi.tl());
+	contoursTimer.stop();
+	Rect boundrec = blobs.blobs()[maxind].bbox + roi.tl();
+	if (scratch.tracking)
+	{
+		scratch.tracker.update(boundrec);
+	}
+
+	/// Find the convex hull (points and indices) and the defects of the hand contour in one pass
+	HandHull& hull = scratch.hull;
+	ScopedStageTimer hullTimer(PROFILE_HULL, &result.times.hull);
+	myConvexHullDefects(contour, hull);
+	hullTimer.stop();
+
+	// count the fingers; nothing is drawn here, see myDrawHand
+	ScopedStageTimer classifyTimer(PROFILE_CLASSIFY, &result.times.classify);
+	result.gesture = myCountFingers(hull.defects, contour, scratch.fingerPoints);
+	result.fingers = (int)scratch.fingerPoints.tips.size();
+	classifyTimer.stop();
+	result.found = true;
+	result.bbox = boundrec;
+	result.center = scratch.fingerPoints.center;
+	// the area of the contour polygon, as contourArea gave it before
+	// Documentation on contourArea: http://docs.opencv.org/modules/imgproc/doc/structural_analysis_and_shape_descriptors.html#
+	result.area = contourArea(contour);
+}
+
+//Function that runs the hand analysis on one frame, and lets the scale controller see how long it took
+void myAnalyzeFrame(Mat& frame, Mat& SkinframeDest, HandScratch& scratch, HandResult& result) {
+	result = HandResult();
+	// the steady clock rather than a stage timer, which is compiled out with GESTURE_NO_PROFILE
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	analyzeFrame(frame, SkinframeDest, scratch, result);
+	if (scratch.draw)
+	{
+		myDrawHand(frame, SkinframeDest, scratch, result);
+	}
+	scratch.scaler.update(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+#include "BlobExtractor.h"
+#include "RoiTracker.h"
+#include "ScaleController.h"
+#include "SkinGate.h"
+#include "SkinModel.h"
+
+/**
+HandAnalysis.h
+
+Hand-analysis stage: pick the hand contour first, then compute its convex hull and convexity defects in one pass.
+The hull comes from a monotone-chain implementation working directly on the (CHAIN_APPROX_SIMPLE) contour,
+and the defect depths are measured while sweeping the contour between consecutive hull vertices.
+myAnalyzeFrame chains the whole per-frame analysis: skin detection, blobs, hull and defects, gesture. The hand is the
+largest blob of the skin mask (see BlobExtractor.h); only its outer contour is traced. In coarse-to-fine mode the blob
+is found on a shrunk frame first and only its bounding box is analysed at full resolution (see ScaleController.h).
+*/
+
+/**
+Convex hull and convexity defects of one contour. The vectors keep their capacity between calls.
+*/
+struct HandHull {
+	std::vector<int> indices;			// hull vertices as indices into the contour, in contour order
+	std::vector<cv::Point> points;		// the same vertices as points
+	std::vector<cv::Vec4i> defects;		// (start index, end index, farthest point index, depth * 256), as from cv::convexityDefects
+	std::vector<int> order;				// scratch used to sort the contour points
+};
+
+/**
+Gesture decided from the number of fingers
+*/
+enum Gesture {
+	GESTURE_NONE,		// no hand in the frame
+	GESTURE_ROCK,		// 0 or 1 finger
+	GESTURE_SCISSOR,	// 2 or 3 fingers
+	GESTURE_PAPER		// more than 3 fingers
+};
+
+/**
+Function that returns the lower-case name of a gesture ("none", "rock", "scissor" or "paper")
+@param gesture The gesture
+*/
+const char* gestureName(Gesture gesture);
+
+/**
+Time spent in each stage of the hand analysis of one frame, in milliseconds
+*/
+struct StageTimes {
+	double skin;		// skin detection
+	double threshold;	// always 0: the blob pass thresholds as it scans; kept for the threshold_ms log column
+	double contours;	// blob extraction and the outer contour of the largest blob
+	double hull;		// convex hull and convexity defects
+	double classify;	// finger counting and gesture decision
+
+	StageTimes() : skin(0), threshold(0), contours(0), hull(0), classify(0) {}
+};
+
+/**
+What the hand analysis found in one frame
+*/
+struct HandResult {
+	bool found;			// false when no blob was found; the fields below are then empty
+	Gesture gesture;
+	int fingers;
+	cv::Rect bbox;		// bounding box of the hand contour, in frame coordinates
+	double area;		// area of the hand contour
+	cv::Point2f center;	// center of the hand (the circle around the contour), in frame coordinates
+	int scale;			// working scale of the coarse pass (1: the whole analysis ran at full resolution)
+	StageTimes times;
+
+	HandResult() : found(false), gesture(GESTURE_NONE), fingers(0), area(0), scale(1) {}
+};
+
+/**
+Function that returns the index of the contour with the largest area, or -1 if there are no contours
+@param contours The contours found in the skin mask
+@param area Receives the area of the returned contour (0 if there is none)
+*/
+int myLargestContour(const std::vector<std::vector<cv::Point> >& contours, double& area);
+
+/**
+Function that computes the convex hull of a contour with Andrew's monotone chain, then its convexity defects
+@param contour The contour (a closed polygon, as returned by findContours)
+@param hull Receives the hull indices, points and defects. Defects are only computed when the hull has more than 3 vertices
+*/
+void myConvexHullDefects(const std::vector<cv::Point>& contour, HandHull& hull);
+
+/**
+Hand center and finger points found by myCountFingers. The vectors keep their capacity between calls.
+*/
+struct HandFingers {
+	cv::Point2f center;					// center of the enclosing circle of the contour
+	float radius;						// its radius
+	std::vector<cv::Point> starts;		// start points of all the convexity defects
+	std::vector<cv::Point> tips;		// the start points counted as fingertips (deep enough and above the center)
+
+	HandFingers() : radius(0) {}
+};
+
+/**
+Function that counts the fingers from the convexity defects and returns the gesture they make. Nothing is drawn
+@param convexityDefectsSet Defects of the contour, as from myConvexHullDefects
+@param mycontour The hand contour
+@param hand Receives the center and the fingertips; the number of fingers is hand.tips.size()
+*/
+Gesture myCountFingers(const std::vector<cv::Vec4i>& convexityDefectsSet, const std::vector<cv::Point>& mycontour, HandFingers& hand);
+
+/**
+Function that draws the hand center, the defect start points and the fingertips found by myCountFingers
+@param frame The BGR image to draw on
+@param hand The points to draw
+*/
+void myDrawFingers(cv::Mat& frame, const HandFingers& hand);
+
+/**
+Function that does some sort of detection of the three image processing: counts the fingers from the convexity defects
+and returns the gesture they make
+@param draw false to skip drawing the hand center and fingertips on the frame
+@param fingers Receives the number of fingers
+**/
+Gesture condefects(const std::vector<cv::Vec4i>& convexityDefectsSet, const std::vector<cv::Point>& mycontour, cv::Mat &frame, bool draw, int& fingers);
+
+/**
+Window of full-resolution skin last written into each of the skin masks a caller cycles through (the pipeline passes
+a few in turn). In tracking and coarse-to-fine modes only a window of the mask is computed, and the rest must read 0:
+instead of clearing the whole mask every frame, only the window an earlier frame wrote into that mask is cleared.
+A mask not seen before, or reallocated, is cleared entirely once.
+*/
+struct SkinWindows {
+	enum { SLOTS = 8 };
+	const unsigned char* data[SLOTS];	// first byte of each known mask, NULL for a free slot
+	cv::Rect window[SLOTS];				// part of that mask that may be non-zero
+	int next;							// slot replaced when a new mask comes
+
+	SkinWindows() : next(0) { for (int i = 0; i < SLOTS; i++) data[i] = 0; }
+
+	/**
+	Function that clears what an earlier frame left in a mask, unless the new window covers all of it, and records the new window
+	@param mask The skin mask about to be written
+	@param window The part of the mask the frame writes
+	@param reallocated true when the mask was just (re)allocated, so its contents are undefined
+	*/
+	void prepare(cv::Mat& mask, const cv::Rect& window, bool reallocated);
+};
+
+/**
+Scratch buffers reused by myAnalyzeFrame from one frame to the next, so the analysis stage stops allocating once warmed up,
+and the tracking state carried between frames. One instance per analysis thread (per stream when there are several).
+*/
+struct HandScratch {
+	HandScratch() : thresh(128), partial(false), tracking(false), draw(true) {}
+
+	// skin mask level above which a pixel belongs to a blob
+	int thresh;
+	// runs and labels of the skin mask, and the outer contour of the largest blob
+	BlobExtractor blobs;
+	std::vector<cv::Point> handContour;
+	// hull and defects of the hand contour only, and the fingers counted from them
+	HandHull hull;
+	HandFingers fingerPoints;
+	// window analysed at full resolution in the last frame; partial when it is not the whole frame
+	cv::Rect window;
+	bool partial;
+	// skin color model used by the skin detection (the RGB rule by default)
+	SkinModel skinModel;
+	// "no hand" test on the skin density: frames without a dense enough region skip everything after the skin detection
+	SkinGate gate;
+	// tracking mode: analyse only a window around the previous hand
+	bool tracking;
+	RoiTracker tracker;
+	// coarse-to-fine mode: working scale of the skin detection and blob search, fixed or kept under a time budget
+	ScaleController scaler;
+	cv::Mat smallFrame;
+	cv::Mat smallSkin;
+	// what is left to clear in the skin masks when only a window of them is computed
+	SkinWindows skinWindows;
+	// false when no overlays are drawn (headless mode) or when they are drawn later from a myCaptureOverlay copy
+	bool draw;
+};
+
+/**
+Function that draws the overlays of the last myAnalyzeFrame call: analysed window, bounding box, hull, hand center and fingertips.
+Nothing is drawn when no hand was found
+@param frame The analysed BGR frame (or a copy of it)
+@param SkinframeDest The skin mask to draw the bounding box and hull on, or an empty Mat
+@param scratch The buffers passed to myAnalyzeFrame
+@param result The result of myAnalyzeFrame
+*/
+void myDrawHand(cv::Mat& frame, cv::Mat& SkinframeDest, const HandScratch& scratch, const HandResult& result);
+
+/**
+What myDrawHand draws, copied out of the scratch buffers so that the overlays can be drawn later and on another thread
+(the one that displays the frame) while the analysis goes on with the next frame. The vectors keep their capacity between frames.
+*/
+struct HandOverlay {
+	bool valid;							// false when nothing was captured for the frame
+	cv::Rect window;					// window analysed at full resolution
+	bool partial;						// the window is not the whole frame
+	std::vector<cv::Point> hull;		// hull of the hand contour
+	HandFingers fingers;				// hand center, defect start points and fingertips
+
+	HandOverlay() : valid(false), partial(false) {}
+};
+
+/**
+Function that copies what the overlays of the last myAnalyzeFrame call need
+@param scratch The buffers passed to myAnalyzeFrame
+@param overlay Receives the copy
+*/
+void myCaptureOverlay(const HandScratch& scratch, HandOverlay& overlay);
+
+/**
+Function that draws captured overlays, as myDrawHand does. Nothing is drawn when no hand was found or nothing was captured
+@param frame The analysed BGR frame
+@param SkinframeDest The skin mask to draw the bounding box and hull on, or an empty Mat
+@param overlay The overlays captured after the analysis of the frame
+@param result The result of the analysis of the frame
+*/
+void myDrawOverlay(cv::Mat& frame, cv::Mat& SkinframeDest, const HandOverlay& overlay, const HandResult& result);
+
+/**
+Function that runs the hand analysis on one frame: skin detection, largest blob and its contour, convex hull and convexity defects.
+The bounding box, hull and fingertips are drawn (with myDrawHand) on the frame and on the skin mask unless scratch.draw is false.
+The time it takes is fed to scratch.scaler, which picks the working scale of the next frame
+@param frame The captured color image
+@param SkinframeDest The destination skin mask, (re)allocated if it does not match the frame size
+@param scratch Buffers reused across frames
+@param result Receives the gesture, finger count, bounding box, contour area and the time spent in each stage
+*/
+void myAnalyzeFrame(cv::Mat& frame, cv::Mat& SkinframeDest, HandScratch& scratch, HandResult& result);
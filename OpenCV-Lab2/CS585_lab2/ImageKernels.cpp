@@ -0,0 +1,132 @@
+#include "ImageKernels.h"
+#include "BackgroundModel.h"
+#include "BandExecutor.h"
+#include "SkinDetect.h"
+
+using namespace cv;
+using namespace std;
+
+//Function that returns the maximum of 3 integers
+int myMax(int a, int b, int c) {
+	int m = a;
+	(void)((m < b) && (m = b));
+	(void)((m < c) && (m = c));
+	return m;
+}
+
+//Function that returns the minimum of 3 integers
+int myMin(int a, int b, int c) {
+	int m = a;
+	(void)((m > b) && (m = b));
+	(void)((m > c) && (m = c));
+	return m;
+}
+
+//Function that detects whether a pixel belongs to the skin based on RGB values
+void mySkinDetect(Mat& src, Mat& dst) {
+	//Surveys of skin color modeling and detection techniques:
+	//Vezhnevets, Vladimir, Vassili Sazonov, and Alla Andreeva. "A survey on pixel-based skin color detection techniques." Proc. Graphicon. Vol. 3. 2003.
+	//Kakumanu, Praveen, Sokratis Makrogiannis, and Nikolaos Bourbakis. "A survey of skin-color modeling and detection methods." Pattern recognition 40.3 (2007): 1106-1122.
+	//The rule is evaluated a whole row at a time by the SIMD kernels in SkinDetect.cpp, which write every mask pixel (255 or 0)
+	//and the rows are split into bands that run on all cores
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			skinDetectRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), src.cols);
+		}
+	});
+}
+
+//Function that detects whether a pixel belongs to the skin with the given color model
+void mySkinDetect(Mat& src, Mat& dst, const SkinModel& model) {
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			model.classifyRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), src.cols);
+		}
+	});
+}
+
+//Function that detects the skin with the given color model and counts the skin pixels for the "no hand" gate
+void mySkinDetect(Mat& src, Mat& dst, const SkinModel& model, SkinGate& gate) {
+	gate.reset(src.size());
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			model.classifyRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), src.cols);
+			gate.countRow(i, dst.ptr<uchar>(i));
+		}
+	});
+}
+
+//Function that does frame differencing between the current frame and the previous frame
+void myFrameDifferencing(Mat& prev, Mat& curr, Mat& dst) {
+	//For more information on operation with arrays: http://docs.opencv.org/modules/core/doc/operations_on_arrays.html
+	//For more information on how to use background subtraction methods: http://docs.opencv.org/trunk/doc/tutorials/video/background_subtraction/background_subtraction.html
+	//absdiff, cvtColor(CV_BGR2GRAY) and the > 50 threshold are fused into one pass that reads both frames once
+	//and writes the mask directly (see BackgroundModel.h)
+	dst.create(curr.rows, curr.cols, CV_8UC1);
+	BandExecutor::shared().run(curr.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			frameDifferenceRow(prev.ptr<uchar>(i), curr.ptr<uchar>(i), dst.ptr<uchar>(i), curr.cols, 50);
+		}
+	});
+}
+
+//Function that accumulates the frame differences for a certain number of pairs of frames
+void myMotionEnergy(const vector<Mat>& mh, Mat& dst) {
+	const Mat& mh0 = mh[0];
+	const Mat& mh1 = mh[1];
+	const Mat& mh2 = mh[2];
+
+	BandExecutor::shared().run(dst.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			const uchar* p0 = mh0.ptr<uchar>(i);
+			const uchar* p1 = mh1.ptr<uchar>(i);
+			const uchar* p2 = mh2.ptr<uchar>(i);
+			uchar* d = dst.ptr<uchar>(i);
+			for (int j = 0; j < dst.cols; j++){
+				if (p0[j] == 255 || p1[j] == 255 || p2[j] == 255){
+					d[j] = 255;
+				}
+			}
+		}
+	});
+}
+
+//Function that detects the skin pixels straight into a bit-packed mask
+void mySkinDetect(Mat& src, BitMask& dst, const SkinModel& model) {
+	dst.create(src.rows, src.cols);
+	BandExecutor::shared().run(src.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			model.classifyRowBits(src.ptr<uchar>(i), dst.row(i), src.cols);
+		}
+	});
+}
+
+//Function that does frame differencing straight into a bit-packed mask
+void myFrameDifferencing(Mat& prev, Mat& curr, BitMask& dst) {
+	dst.create(curr.rows, curr.cols);
+	BandExecutor::shared().run(curr.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			frameDifferenceRowBits(prev.ptr<uchar>(i), curr.ptr<uchar>(i), dst.row(i), curr.cols, 50);
+		}
+	});
+}
+
+//Function that accumulates bit-packed frame differences
+void myMotionEnergy(const vector<BitMask>& mh, BitMask& dst) {
+	dst.create(mh[0].rows(), mh[0].cols());
+	const int words = dst.wordsPerRow();
+	BandExecutor::shared().run(dst.rows(), [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			unsigned long long* d = dst.row(i);
+			for (int k = 0; k < words; k++){
+				d[k] = 0;
+			}
+			for (size_t m = 0; m < mh.size(); m++){
+				const unsigned long long* s = mh[m].row(i);
+				for (int k = 0; k < words; k++){
+					d[k] |= s[k];
+				}
+			}
+		}
+	});
+}
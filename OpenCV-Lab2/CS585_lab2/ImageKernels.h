@@ -0,0 +1,97 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+#include "BitMask.h"
+#include "SkinGate.h"
+#include "SkinModel.h"
+
+/**
+ImageKernels.h
+
+The per-pixel kernels of the lab (skin detection, frame differencing, motion energy), split out of Source.cpp
+so the benchmarks can link them. The loops run in bands of rows on the shared BandExecutor.
+*/
+
+/**
+Function that returns the maximum of 3 integers
+@param a first integer
+@param b second integer
+@param c third integer
+*/
+int myMax(int a, int b, int c);
+
+/**
+Function that returns the minimum of 3 integers
+@param a first integer
+@param b second integer
+@param c third integer
+*/
+int myMin(int a, int b, int c);
+
+/**
+Function that detects whether a pixel belongs to the skin based on RGB values
+@param src The source color image
+@param dst The destination grayscale image where skin pixels are colored white and the rest are colored black
+*/
+void mySkinDetect(cv::Mat& src, cv::Mat& dst);
+
+/**
+Function that detects whether a pixel belongs to the skin with the given color model (one table lookup per pixel)
+@param src The source color image
+@param dst The destination grayscale image where skin pixels are colored white and the rest are colored black
+@param model The skin color model
+*/
+void mySkinDetect(cv::Mat& src, cv::Mat& dst, const SkinModel& model);
+
+/**
+Function that detects whether a pixel belongs to the skin with the given color model, and counts the skin pixels
+of each row for the "no hand" gate while the row is still in the cache
+@param src The source color image
+@param dst The destination grayscale image where skin pixels are colored white and the rest are colored black
+@param model The skin color model
+@param gate Receives the counts (see SkinGate.h)
+*/
+void mySkinDetect(cv::Mat& src, cv::Mat& dst, const SkinModel& model, SkinGate& gate);
+
+/**
+Function that detects the skin pixels straight into a bit-packed mask
+@param src The source color image
+@param dst The destination mask (sized to src)
+@param model The skin color model
+*/
+void mySkinDetect(cv::Mat& src, BitMask& dst, const SkinModel& model);
+
+/**
+Function that does frame differencing between the current frame and the previous frame
+@param src The current color image
+@param prev The previous color image
+@param dst The destination grayscale image where pixels are colored white if the corresponding pixel intensities in the current
+and previous image are not the same
+*/
+void myFrameDifferencing(cv::Mat& prev, cv::Mat& curr, cv::Mat& dst);
+
+/**
+Function that does frame differencing straight into a bit-packed mask
+@param prev The previous color image
+@param curr The current color image
+@param dst The destination mask (sized to curr), set where the gray level of the difference is above 50
+*/
+void myFrameDifferencing(cv::Mat& prev, cv::Mat& curr, BitMask& dst);
+
+/**
+Function that accumulates the frame differences for a certain number of pairs of frames
+(reference version for three masks; the main loop uses the MotionHistory engine)
+@param mh Vector of frame difference images
+@param dst The destination grayscale image to store the accumulation of the frame difference images
+*/
+void myMotionEnergy(const std::vector<cv::Mat>& mh, cv::Mat& dst);
+
+/**
+Function that accumulates bit-packed frame differences: one OR per 64 pixels and mask
+@param mh Frame difference masks, all of the same size
+@param dst The destination mask (sized to the masks)
+*/
+void myMotionEnergy(const std::vector<BitMask>& mh, BitMask& dst);
@@ -0,0 +1,103 @@
+#include "MotionHistory.h"
+#include "BandExecutor.h"
+
+#include <algorithm>
+
+using namespace cv;
+
+MotionHistory::MotionHistory(int window)
+	: m_window(std::max(1, window)), m_frame(1)
+{
+}
+
+void MotionHistory::setWindow(int window)
+{
+	m_window = std::max(1, window);
+}
+
+void MotionHistory::reset()
+{
+	m_frame = 1;
+	if (!m_stamps.empty()) {
+		m_stamps.setTo(Scalar(0));
+	}
+}
+
+int MotionHistory::oldest() const
+{
+	return std::max(1, m_frame - m_window);
+}
+
+void MotionHistory::update(const Mat& motionMask)
+{
+	if (m_stamps.rows != motionMask.rows || m_stamps.cols != motionMask.cols) {
+		m_stamps = Mat::zeros(motionMask.rows, motionMask.cols, CV_32SC1);
+		m_frame = 1;
+	}
+	const int stamp = m_frame;
+	Mat& stamps = m_stamps;
+	BandExecutor::shared().run(motionMask.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			const uchar* m = motionMask.ptr<uchar>(i);
+			int* s = stamps.ptr<int>(i);
+			for (int j = 0; j < motionMask.cols; j++){
+				s[j] = m[j] ? stamp : s[j];
+			}
+		}
+	});
+	m_frame++;
+}
+
+void MotionHistory::energy(Mat& dst) const
+{
+	dst.create(m_stamps.rows, m_stamps.cols, CV_8UC1);
+	const int limit = oldest();
+	const Mat& stamps = m_stamps;
+	BandExecutor::shared().run(stamps.rows, [&](int first, int end) {
+		for (int i = first; i < end; i++){
+			const int* s = stamps.ptr<int>(i);
+			uchar* d = dst.ptr<uchar>(i);
+			for (int j = 0; j < stamps.cols; j++){
+				d[j] = s[j] >= limit ? 255 : 0;
+			}
+		}
+	});
+}
+
+void MotionHistory::orientation(Mat& orientation, Mat& valid) const
+{
+	orientation.create(m_stamps.rows, m_stamps.cols, CV_32FC1);
+	valid.create(m_stamps.rows, m_stamps.cols, CV_8UC1);
+	orientation.setTo(Scalar(0));
+	valid.setTo(Scalar(0));
+	if (m_stamps.rows < 3 || m_stamps.cols < 3) {
+		return;
+	}
+
+	const int limit = oldest();
+	const Mat& stamps = m_stamps;
+	//3x3 Sobel on the timestamps, for the interior pixels whose whole neighbourhood moved within the window
+	BandExecutor::shared().run(stamps.rows - 2, [&](int first, int end) {
+		for (int i = first + 1; i < end + 1; i++){
+			const int* up = stamps.ptr<int>(i - 1);
+			const int* mid = stamps.ptr<int>(i);
+			const int* down = stamps.ptr<int>(i + 1);
+			float* o = orientation.ptr<float>(i);
+			uchar* v = valid.ptr<uchar>(i);
+			for (int j = 1; j < stamps.cols - 1; j++){
+				int lowest = std::min(std::min(std::min(up[j - 1], up[j]), std::min(up[j + 1], mid[j - 1])),
+					std::min(std::min(mid[j], mid[j + 1]), std::min(std::min(down[j - 1], down[j]), down[j + 1])));
+				if (lowest < limit) {
+					continue;
+				}
+				float gx = (float)((up[j + 1] + 2 * mid[j + 1] + down[j + 1]) - (up[j - 1] + 2 * mid[j - 1] + down[j - 1]));
+				float gy = (float)((down[j - 1] + 2 * down[j] + down[j + 1]) - (up[j - 1] + 2 * up[j] + up[j + 1]));
+				if (gx == 0 && gy == 0) {
+					continue;
+				}
+				o[j] = fastAtan2(gy, gx);
+				v[j] = 255;
+			}
+		}
+	});
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+/**
+MotionHistory.h
+
+Timestamped motion-history image. Instead of keeping the last K motion masks and OR-ing them on every frame,
+a single buffer stores for each pixel the number of the last frame in which it moved. Updating it costs one pass
+over the pixels whatever the window length K is, and the motion energy (pixels that moved in the last K frames)
+and the motion gradient orientation are computed from it only when asked for.
+*/
+class MotionHistory {
+public:
+	/**
+	@param window Number of frames K a pixel stays in the motion energy after it last moved
+	*/
+	explicit MotionHistory(int window = 3);
+
+	/**
+	Stamps every non-zero pixel of the motion mask with the current frame number, then advances the frame number
+	@param motionMask Binary CV_8UC1 mask of the pixels that moved in this frame; the history is reset if its size changes
+	*/
+	void update(const cv::Mat& motionMask);
+
+	/**
+	Function that writes the motion energy: 255 where a pixel moved within the last K updates, 0 elsewhere
+	@param dst The destination CV_8UC1 image (allocated if needed)
+	*/
+	void energy(cv::Mat& dst) const;
+
+	/**
+	Function that computes the direction in which the motion moves, from the gradient of the timestamps
+	@param orientation The destination CV_32FC1 image with the angle in degrees [0, 360), 0 where not valid
+	@param valid The destination CV_8UC1 mask, 255 where the whole 3x3 neighbourhood is within the window and the gradient is not zero
+	*/
+	void orientation(cv::Mat& orientation, cv::Mat& valid) const;
+
+	/**
+	Function that returns the window length K
+	*/
+	int window() const { return m_window; }
+
+	/**
+	Changes the window length K; takes effect immediately, no history is lost
+	@param window Number of frames
+	*/
+	void setWindow(int window);
+
+	/**
+	Clears the history
+	*/
+	void reset();
+
+private:
+	//oldest timestamp still inside the window
+	int oldest() const;
+
+	int m_window;
+	int m_frame;		// number given to the next update, starts at 1 (0 means "never moved")
+	cv::Mat m_stamps;	// CV_32SC1, frame number of the last motion at each pixel
+};
@@ -0,0 +1,262 @@
+#include "RawVideo.h"
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace cv;
+
+static const char RAW_MAGIC[8] = { 'G', 'E', 'S', 'T', 'R', 'A', 'W', '1' };
+static const unsigned int RAW_VERSION = 1;
+static const size_t RAW_ALIGN = 64;
+
+//File header, 64 bytes
+struct RawHeader {
+	char magic[8];
+	unsigned int version;
+	int width;
+	int height;
+	int type;
+	unsigned long long recordSize;	// bytes from one record to the next
+	unsigned long long frames;		// written by RawRecorder::close; 0 when the recording was not closed
+	unsigned char reserved[24];
+};
+
+//Record header, 64 bytes; the pixels follow
+struct RawRecordHeader {
+	long long timestampNs;
+	unsigned long long frame;
+	unsigned char reserved[48];
+};
+
+static_assert(sizeof(RawHeader) == RAW_ALIGN && sizeof(RawRecordHeader) == RAW_ALIGN, "raw headers are 64 bytes");
+
+// largest width or height a replay accepts, so that the size of a frame cannot overflow
+static const int RAW_MAX_SIDE = 1 << 15;
+
+//Tells whether a header read from a file describes frames that can be replayed
+static bool validHeader(const RawHeader& header)
+{
+	// a plain OpenCV type (depth up to CV_64F, 1 to 4 channels) before anything is derived from it
+	int depth = CV_MAT_DEPTH(header.type), channels = CV_MAT_CN(header.type);
+	if (header.version != RAW_VERSION || depth > CV_64F || channels < 1 || channels > 4 || header.type != CV_MAKETYPE(depth, channels)
+		|| header.width <= 0 || header.height <= 0 || header.width > RAW_MAX_SIDE || header.height > RAW_MAX_SIDE) {
+		return false;
+	}
+	size_t pixels = (size_t)header.width * header.height * CV_ELEM_SIZE(header.type);
+	return header.recordSize >= sizeof(RawRecordHeader) + pixels && header.recordSize % RAW_ALIGN == 0;
+}
+
+RawRecorder::RawRecorder() : m_file(NULL), m_type(0), m_recordSize(0), m_frames(0), m_firstTick(0)
+{
+}
+
+RawRecorder::~RawRecorder()
+{
+	close();
+}
+
+bool RawRecorder::open(const std::string& path)
+{
+	close();
+	m_file = std::fopen(path.c_str(), "wb");
+	m_frames = 0;
+	m_recordSize = 0;
+	return m_file != NULL;
+}
+
+bool RawRecorder::write(const Mat& frame)
+{
+	if (!m_file || frame.empty()) {
+		return false;
+	}
+	size_t rowBytes = frame.cols * frame.elemSize();
+	if (m_frames == 0) {
+		// the first frame fixes the layout of every record
+		m_size = frame.size();
+		m_type = frame.type();
+		size_t pixels = rowBytes * frame.rows;
+		m_recordSize = sizeof(RawRecordHeader) + (pixels + RAW_ALIGN - 1) / RAW_ALIGN * RAW_ALIGN;
+		m_firstTick = getTickCount();
+		RawHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, RAW_MAGIC, sizeof(RAW_MAGIC));
+		header.version = RAW_VERSION;
+		header.width = m_size.width;
+		header.height = m_size.height;
+		header.type = m_type;
+		header.recordSize = m_recordSize;
+		if (std::fwrite(&header, sizeof(header), 1, m_file) != 1) {
+			return false;
+		}
+	}
+	else if (frame.size() != m_size || frame.type() != m_type) {
+		return false;
+	}
+
+	RawRecordHeader record;
+	std::memset(&record, 0, sizeof(record));
+	record.timestampNs = (long long)((getTickCount() - m_firstTick) * (1e9 / getTickFrequency()));
+	record.frame = m_frames;
+	bool ok = std::fwrite(&record, sizeof(record), 1, m_file) == 1;
+	// row by row, so frames that are views into a larger image are recorded too
+	for (int i = 0; ok && i < frame.rows; i++) {
+		ok = std::fwrite(frame.ptr(i), 1, rowBytes, m_file) == rowBytes;
+	}
+	static const unsigned char padding[RAW_ALIGN] = { 0 };
+	size_t pad = (size_t)(m_recordSize - sizeof(record) - rowBytes * frame.rows);
+	ok = ok && (pad == 0 || std::fwrite(padding, 1, pad, m_file) == pad);
+	if (ok) {
+		m_frames++;
+	}
+	return ok;
+}
+
+void RawRecorder::close()
+{
+	if (!m_file) {
+		return;
+	}
+	if (m_frames > 0 && std::fseek(m_file, (long)offsetof(RawHeader, frames), SEEK_SET) == 0) {
+		std::fwrite(&m_frames, sizeof(m_frames), 1, m_file);
+	}
+	std::fclose(m_file);
+	m_file = NULL;
+}
+
+RawReplay::RawReplay() : m_data(NULL), m_length(0), m_frames(0), m_next(0), m_type(0), m_recordSize(0)
+#ifdef _WIN32
+	, m_mapping(NULL)
+#endif
+{
+}
+
+RawReplay::~RawReplay()
+{
+	close();
+}
+
+bool RawReplay::isRecording(const std::string& path)
+{
+	char magic[sizeof(RAW_MAGIC)];
+	std::FILE* f = std::fopen(path.c_str(), "rb");
+	if (!f) {
+		return false;
+	}
+	bool ok = std::fread(magic, 1, sizeof(magic), f) == sizeof(magic) && std::memcmp(magic, RAW_MAGIC, sizeof(magic)) == 0;
+	std::fclose(f);
+	return ok;
+}
+
+bool RawReplay::open(const std::string& path)
+{
+	close();
+	if (!isRecording(path)) {
+		return false;
+	}
+	// a read-only mapping: the frames are the page cache itself, never copied (nothing may draw on them)
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart >= (LONGLONG)sizeof(RawHeader)) {
+		m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_mapping) {
+			m_data = (unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+			m_length = (size_t)size.QuadPart;
+		}
+	}
+	CloseHandle(file);
+	if (!m_data) {
+		close();
+		return false;
+	}
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(RawHeader)) {
+		void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			m_data = (unsigned char*)data;
+			m_length = (size_t)info.st_size;
+			// frames are read in order: let the kernel read ahead
+			madvise(data, m_length, MADV_SEQUENTIAL);
+		}
+	}
+	::close(fd);
+	if (!m_data) {
+		return false;
+	}
+#endif
+
+	RawHeader header;
+	std::memcpy(&header, m_data, sizeof(header));
+	if (!validHeader(header)) {
+		close();
+		return false;
+	}
+	m_size = Size(header.width, header.height);
+	m_type = header.type;
+	m_recordSize = (size_t)header.recordSize;
+	// the whole records in the file; a recording that was not closed has no frame count in its header
+	m_frames = (m_length - sizeof(RawHeader)) / m_recordSize;
+	if (header.frames > 0 && header.frames < m_frames) {
+		m_frames = (size_t)header.frames;
+	}
+	m_next = 0;
+	return true;
+}
+
+void RawReplay::close()
+{
+#ifdef _WIN32
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+		m_mapping = NULL;
+	}
+#else
+	if (m_data) {
+		munmap(m_data, m_length);
+	}
+#endif
+	m_data = NULL;
+	m_length = 0;
+	m_frames = 0;
+	m_next = 0;
+}
+
+bool RawReplay::frame(size_t index, Mat& frame, long long* timestampNs) const
+{
+	if (index >= m_frames) {
+		return false;
+	}
+	unsigned char* record = m_data + sizeof(RawHeader) + index * m_recordSize;
+	if (timestampNs) {
+		*timestampNs = ((const RawRecordHeader*)record)->timestampNs;
+	}
+	// a header over the mapped pixels: nothing is allocated or copied
+	frame = Mat(m_size, m_type, record + sizeof(RawRecordHeader));
+	return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <cstdio>
+#include <string>
+
+/**
+RawVideo.h
+
+Bit-exact recording and replay of camera frames, without a codec. A recording is one file:
+
+	header		64 bytes: magic "GESTRAW1", format version, width, height, OpenCV type, record size, frame count
+	record 0	64-byte record header (capture timestamp in ns from the first frame, frame number), then the pixels
+	record 1	...
+
+Every record has the same size, a multiple of 64 bytes, so frame i starts at 64 + i * record size and its pixels are
+64-byte aligned: the index is implicit, and a recording cut short by a crash is still readable up to its last whole
+record. Numbers are stored in the byte order of the machine that recorded them (little endian on x86).
+The replay maps the file into memory and hands out cv::Mat headers that point into the mapping: no decode, no copy.
+The mapping is read-only: a replayed frame must not be written to (the display draws its overlays on a copy).
+*/
+
+class RawRecorder {
+public:
+	RawRecorder();
+	~RawRecorder();
+
+	/**
+	Function that creates (or truncates) the recording, returns false if it cannot be created.
+	The frame size and type are taken from the first frame written
+	@param path Name of the file
+	*/
+	bool open(const std::string& path);
+
+	/**
+	Function that appends a frame stamped with the time since the first frame, returns false if it cannot be written
+	or if its size or type differ from those of the first frame
+	@param frame The frame (any type; the labs record CV_8UC3 BGR frames)
+	*/
+	bool write(const cv::Mat& frame);
+
+	/**
+	Writes the frame count into the header and closes the file
+	*/
+	void close();
+
+	/**
+	Function that tells whether a recording is open
+	*/
+	bool isOpen() const { return m_file != NULL; }
+
+	/**
+	Function that returns the number of frames written
+	*/
+	unsigned long long frames() const { return m_frames; }
+
+private:
+	RawRecorder(const RawRecorder&);
+	RawRecorder& operator=(const RawRecorder&);
+
+	std::FILE* m_file;
+	cv::Size m_size;
+	int m_type;
+	unsigned long long m_recordSize;
+	unsigned long long m_frames;
+	long long m_firstTick;		// cv::getTickCount() of the first frame
+};
+
+class RawReplay {
+public:
+	RawReplay();
+	~RawReplay();
+
+	/**
+	Function that maps a recording, returns false if the file cannot be mapped or is not a recording,
+	or if its header gives an unknown pixel type or an impossible frame size
+	@param path Name of the file
+	*/
+	bool open(const std::string& path);
+
+	/**
+	Unmaps the recording; the frames handed out become invalid
+	*/
+	void close();
+
+	/**
+	Function that tells whether a recording is mapped
+	*/
+	bool isOpen() const { return m_data != NULL; }
+
+	/**
+	Function that returns the number of whole frames in the recording
+	*/
+	size_t frames() const { return m_frames; }
+
+	/**
+	Function that gives a frame of the recording, returns false past the last one
+	@param index Number of the frame, from 0
+	@param frame Receives a read-only header pointing into the mapping, valid until close()
+	@param timestampNs Receives the capture time of the frame, in ns from the first frame (may be NULL)
+	*/
+	bool frame(size_t index, cv::Mat& frame, long long* timestampNs = NULL) const;
+
+	/**
+	Function that gives the frame after the last one read, returns false at the end of the recording
+	@param frame Receives a read-only header pointing into the mapping, valid until close()
+	*/
+	bool read(cv::Mat& frame) { return this->frame(m_next++, frame); }
+
+	/**
+	Function that tells whether a file starts like a recording
+	@param path Name of the file
+	*/
+	static bool isRecording(const std::string& path);
+
+private:
+	RawReplay(const RawReplay&);
+	RawReplay& operator=(const RawReplay&);
+
+	unsigned char* m_data;
+	size_t m_length;
+	size_t m_frames;
+	size_t m_next;
+	cv::Size m_size;
+	int m_type;
+	size_t m_recordSize;
+#ifdef _WIN32
+	void* m_mapping;			// HANDLE of the file mapping
+#endif
+};
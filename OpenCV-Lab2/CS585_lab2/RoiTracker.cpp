@@ -0,0 +1,76 @@
+#include "RoiTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+
+RoiTracker::RoiTracker(int refreshInterval, double marginScale, int minMargin)
+	: m_refreshInterval(std::max(1, refreshInterval)), m_marginScale(marginScale), m_minMargin(minMargin),
+	m_hasTrack(false), m_fullScan(true), m_framesSinceFull(0)
+{
+}
+
+void RoiTracker::reset()
+{
+	m_hasTrack = false;
+	m_velocity = Point2f(0, 0);
+}
+
+Rect RoiTracker::searchWindow(Size frameSize)
+{
+	Rect frameRect(0, 0, frameSize.width, frameSize.height);
+	m_frame = frameSize;
+	if (!m_hasTrack || m_framesSinceFull >= m_refreshInterval) {
+		m_fullScan = true;
+		m_framesSinceFull = 0;
+		m_window = frameRect;
+		return m_window;
+	}
+
+	//predict where the box will be, then grow it by a margin that covers the hand size and its speed
+	int dx = cvRound(m_velocity.x);
+	int dy = cvRound(m_velocity.y);
+	int speed = (int)std::ceil(std::max(std::fabs(m_velocity.x), std::fabs(m_velocity.y)));
+	int margin = std::max(m_minMargin, (int)(m_marginScale * std::max(m_last.width, m_last.height))) + speed;
+	Rect predicted(m_last.x + dx - margin, m_last.y + dy - margin, m_last.width + 2 * margin, m_last.height + 2 * margin);
+
+	m_fullScan = false;
+	m_framesSinceFull++;
+	m_window = predicted & frameRect;
+	if (m_window.area() == 0) {
+		//the prediction left the frame
+		m_fullScan = true;
+		m_framesSinceFull = 0;
+		m_window = frameRect;
+	}
+	return m_window;
+}
+
+void RoiTracker::update(const Rect& hand)
+{
+	if (hand.area() == 0) {
+		reset();
+		return;
+	}
+
+	//a box that reaches the edge of a partial window may be cut off there, so look at the whole frame next time
+	if (!m_fullScan) {
+		//(edges of the window that are also edges of the frame do not count)
+		bool touchesEdge = (m_window.x > 0 && hand.x <= m_window.x) ||
+			(m_window.y > 0 && hand.y <= m_window.y) ||
+			(m_window.x + m_window.width < m_frame.width && hand.x + hand.width >= m_window.x + m_window.width) ||
+			(m_window.y + m_window.height < m_frame.height && hand.y + hand.height >= m_window.y + m_window.height);
+		if (touchesEdge) {
+			reset();
+			return;
+		}
+	}
+
+	if (m_hasTrack) {
+		m_velocity = Point2f((hand.x + hand.width * 0.5f) - (m_last.x + m_last.width * 0.5f),
+			(hand.y + hand.height * 0.5f) - (m_last.y + m_last.height * 0.5f));
+	}
+	m_last = hand;
+	m_hasTrack = true;
+}
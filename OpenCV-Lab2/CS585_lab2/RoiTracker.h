@@ -0,0 +1,56 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+/**
+RoiTracker.h
+
+Tracking mode for the hand analysis: instead of scanning the whole frame, skin detection and contour extraction
+run inside a window predicted from the previous hand bounding box. The box is moved by a constant-velocity
+predictor and grown by a margin that scales with the hand size and its speed.
+A full-frame scan is done every refreshInterval frames, and whenever the hand is lost or reaches the window edge.
+*/
+class RoiTracker {
+public:
+	/**
+	@param refreshInterval Number of frames between two forced full-frame scans
+	@param marginScale Margin added on each side of the predicted box, as a fraction of the box size
+	@param minMargin Smallest margin in pixels
+	*/
+	explicit RoiTracker(int refreshInterval = 30, double marginScale = 0.25, int minMargin = 16);
+
+	/**
+	Function that returns the window to analyse in the next frame (the whole frame when a full scan is due)
+	@param frameSize Size of the frame
+	*/
+	cv::Rect searchWindow(cv::Size frameSize);
+
+	/**
+	Records the result of the analysis of the window returned by the last searchWindow call
+	@param hand Bounding box of the hand in frame coordinates, or an empty rectangle if no hand was found
+	*/
+	void update(const cv::Rect& hand);
+
+	/**
+	Function that tells whether the last window returned was the whole frame
+	*/
+	bool lastWasFullScan() const { return m_fullScan; }
+
+	/**
+	Forgets the track, so that the next frame is a full scan
+	*/
+	void reset();
+
+private:
+	int m_refreshInterval;
+	double m_marginScale;
+	int m_minMargin;
+
+	bool m_hasTrack;
+	cv::Rect m_last;			// last hand box
+	cv::Point2f m_velocity;		// motion of the box centre per frame
+	cv::Rect m_window;			// window handed out by the last searchWindow call
+	cv::Size m_frame;			// frame size passed to the last searchWindow call
+	bool m_fullScan;
+	int m_framesSinceFull;
+};
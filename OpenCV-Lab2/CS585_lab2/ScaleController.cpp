@@ -0,0 +1,45 @@
+#include "ScaleController.h"
+
+#include <algorithm>
+
+//Smoothing of the moving average, and frames to wait after a change so that the average settles at the new scale
+static const double AVERAGE_WEIGHT = 0.2;
+static const int HOLD_FRAMES = 8;
+
+//Largest power of two in {1, 2, 4} that is not above n
+static int roundScale(int n)
+{
+	return n >= 4 ? 4 : n >= 2 ? 2 : 1;
+}
+
+ScaleController::ScaleController(double budgetMs, int initialScale, int maxScale)
+	: m_budgetMs(std::max(0.0, budgetMs)), m_maxScale(roundScale(maxScale)), m_averageMs(-1), m_hold(0)
+{
+	m_scale = std::min(roundScale(initialScale), m_maxScale);
+}
+
+void ScaleController::update(double frameMs)
+{
+	m_averageMs = m_averageMs < 0 ? frameMs : m_averageMs + AVERAGE_WEIGHT * (frameMs - m_averageMs);
+	if (m_budgetMs <= 0) {
+		return;
+	}
+	if (m_hold > 0) {
+		m_hold--;
+		return;
+	}
+
+	int next = m_scale;
+	if (m_averageMs > m_budgetMs && m_scale < m_maxScale) {
+		next = m_scale * 2;
+	}
+	//halving the scale quadruples the coarse work; the refinement does not change, so this leaves some headroom
+	else if (m_scale > 1 && m_averageMs * 3 < m_budgetMs * 0.8) {
+		next = m_scale / 2;
+	}
+	if (next != m_scale) {
+		m_scale = next;
+		m_averageMs = -1;
+		m_hold = HOLD_FRAMES;
+	}
+}
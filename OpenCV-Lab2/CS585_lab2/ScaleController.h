@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ScaleController.h
+
+Working-scale controller for the coarse-to-fine mode of the hand analysis. The skin detection and the blob search
+run on the frame shrunk by the working scale (1, 2 or 4), and only the bounding box of the hand found there is
+analysed again at full resolution. With a time budget the controller follows the analysis time of the recent frames
+and moves to a coarser scale when they go over the budget, and back to a finer one when there is room for the
+(about 4 times) larger cost, so the latency stays steady whatever the camera resolution is.
+*/
+class ScaleController {
+public:
+	/**
+	@param budgetMs Analysis time per frame to stay under, in milliseconds; 0 keeps the scale fixed
+	@param initialScale Working scale to start with (rounded down to 1, 2 or 4)
+	@param maxScale Coarsest scale the controller may pick (1, 2 or 4)
+	*/
+	explicit ScaleController(double budgetMs = 0, int initialScale = 1, int maxScale = 4);
+
+	/**
+	Function that returns the working scale for the next frame: 1 for full resolution, 2 or 4 for 1/2 or 1/4
+	*/
+	int scale() const { return m_scale; }
+
+	/**
+	Records the analysis time of a frame and adjusts the working scale
+	@param frameMs Time the analysis of the frame took, in milliseconds
+	*/
+	void update(double frameMs);
+
+	/**
+	Function that returns the smoothed analysis time at the current scale, in milliseconds
+	*/
+	double averageMs() const { return m_averageMs; }
+
+private:
+	double m_budgetMs;
+	int m_maxScale;
+	int m_scale;
+	double m_averageMs;	// exponential moving average, < 0 until the first frame at the current scale
+	int m_hold;			// frames left before the scale may change again
+};
@@ -0,0 +1,265 @@
+#include "SkinDetect.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SKIN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSSE3/AVX2 instructions inside functions that ask for them;
+// MSVC always accepts the intrinsics, so the attributes expand to nothing there.
+#if defined(SKIN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SKIN_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define SKIN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SKIN_TARGET_SSSE3
+#define SKIN_TARGET_AVX2
+#endif
+
+// The rule from mySkinDetect is
+//	R > 95 && G > 40 && B > 20 && max(R,G,B) - min(R,G,B) > 15 && |R - G| > 15 && R > G && R > B
+// Since R > G and R > B, max(R,G,B) is R, so |R - G| > 15 becomes R - G > 15, which already implies R > G
+// and R - min(G,B) > 15. The kernels below evaluate the equivalent form
+//	R > 95 && G > 40 && B > 20 && R > B && R - G > 15
+
+void skinDetectRowScalar(const unsigned char* bgr, unsigned char* mask, int width) {
+	for (int j = 0; j < width; j++, bgr += 3){
+		int B = bgr[0]; int G = bgr[1]; int R = bgr[2];
+		int skin = (R > 95) & (G > 40) & (B > 20) & (R > B) & (R - G > 15);
+		mask[j] = (unsigned char)-skin;
+	}
+}
+
+void skinDetectRowBitsScalar(const unsigned char* bgr, unsigned long long* bits, int width) {
+	for (int j = 0; j < width; j += 64){
+		unsigned long long w = 0;
+		int n = width - j < 64 ? width - j : 64;
+		for (int k = 0; k < n; k++, bgr += 3){
+			int B = bgr[0]; int G = bgr[1]; int R = bgr[2];
+			unsigned long long skin = (R > 95) & (G > 40) & (B > 20) & (R > B) & (R - G > 15);
+			w |= skin << k;
+		}
+		bits[j >> 6] = w;
+	}
+}
+
+#ifdef SKIN_X86
+
+// pshufb masks that gather the B, G and R bytes of 16 interleaved pixels (48 bytes, loaded as three 16 byte chunks)
+// into 16 consecutive lanes. Each chunk contributes a disjoint set of lanes, -1 clears the rest.
+#define SKIN_SHUF_B0 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+#define SKIN_SHUF_B1 -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1
+#define SKIN_SHUF_B2 -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13
+#define SKIN_SHUF_G0 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+#define SKIN_SHUF_G1 -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1
+#define SKIN_SHUF_G2 -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14
+#define SKIN_SHUF_R0 2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+#define SKIN_SHUF_R1 -1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1
+#define SKIN_SHUF_R2 -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15
+
+//Function that classifies the 16 pixels at bgr with SSSE3, returns 0xFF in the lanes that are NOT skin
+SKIN_TARGET_SSSE3
+static inline __m128i skinRejectSSSE3(const unsigned char* bgr) {
+	const __m128i b0 = _mm_setr_epi8(SKIN_SHUF_B0), b1 = _mm_setr_epi8(SKIN_SHUF_B1), b2 = _mm_setr_epi8(SKIN_SHUF_B2);
+	const __m128i g0 = _mm_setr_epi8(SKIN_SHUF_G0), g1 = _mm_setr_epi8(SKIN_SHUF_G1), g2 = _mm_setr_epi8(SKIN_SHUF_G2);
+	const __m128i r0 = _mm_setr_epi8(SKIN_SHUF_R0), r1 = _mm_setr_epi8(SKIN_SHUF_R1), r2 = _mm_setr_epi8(SKIN_SHUF_R2);
+	const __m128i c95 = _mm_set1_epi8(95), c40 = _mm_set1_epi8(40), c20 = _mm_set1_epi8(20), c15 = _mm_set1_epi8(15);
+
+	__m128i v0 = _mm_loadu_si128((const __m128i*)bgr);
+	__m128i v1 = _mm_loadu_si128((const __m128i*)(bgr + 16));
+	__m128i v2 = _mm_loadu_si128((const __m128i*)(bgr + 32));
+	__m128i B = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, b0), _mm_shuffle_epi8(v1, b1)), _mm_shuffle_epi8(v2, b2));
+	__m128i G = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, g0), _mm_shuffle_epi8(v1, g1)), _mm_shuffle_epi8(v2, g2));
+	__m128i R = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, r0), _mm_shuffle_epi8(v1, r1)), _mm_shuffle_epi8(v2, r2));
+
+	//Each term is a saturating difference that is non-zero exactly when its comparison holds,
+	//so a pixel is skin when the minimum of all terms is non-zero
+	__m128i t = _mm_min_epu8(_mm_subs_epu8(R, c95), _mm_subs_epu8(G, c40));
+	t = _mm_min_epu8(t, _mm_subs_epu8(B, c20));
+	t = _mm_min_epu8(t, _mm_subs_epu8(R, B));
+	t = _mm_min_epu8(t, _mm_subs_epu8(_mm_subs_epu8(R, G), c15));
+	return _mm_cmpeq_epi8(t, _mm_setzero_si128());
+}
+
+//Function that classifies 16 pixels per step with SSSE3
+SKIN_TARGET_SSSE3
+static void skinDetectRowSSSE3(const unsigned char* bgr, unsigned char* mask, int width) {
+	const __m128i ones = _mm_set1_epi8(-1);
+	int j = 0;
+	for (; j + 16 <= width; j += 16, bgr += 48){
+		_mm_storeu_si128((__m128i*)(mask + j), _mm_xor_si128(skinRejectSSSE3(bgr), ones));
+	}
+	skinDetectRowScalar(bgr, mask + j, width - j);
+}
+
+//Function that packs 64 pixels per word with SSSE3 (four steps of 16)
+SKIN_TARGET_SSSE3
+static void skinDetectRowBitsSSSE3(const unsigned char* bgr, unsigned long long* bits, int width) {
+	int j = 0;
+	for (; j + 64 <= width; j += 64, bgr += 192){
+		unsigned long long w = 0;
+		for (int k = 0; k < 4; k++){
+			w |= (unsigned long long)(unsigned)(~_mm_movemask_epi8(skinRejectSSSE3(bgr + 48 * k)) & 0xFFFF) << (16 * k);
+		}
+		bits[j >> 6] = w;
+	}
+	skinDetectRowBitsScalar(bgr, bits + (j >> 6), width - j);
+}
+
+//Function that loads 16 bytes at p into the low lane and 16 bytes at p + 48 into the high lane
+SKIN_TARGET_AVX2
+static inline __m256i skinLoadPair(const unsigned char* p) {
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+		_mm_loadu_si128((const __m128i*)(p + 48)), 1);
+}
+
+//Function that classifies the 32 pixels at bgr with AVX2, returns 0xFF in the lanes that are NOT skin
+//The low lane holds pixels 0-15 and the high lane pixels 16-31, so the per-lane SSSE3 shuffles apply unchanged
+SKIN_TARGET_AVX2
+static inline __m256i skinRejectAVX2(const unsigned char* bgr) {
+	const __m256i b0 = _mm256_setr_epi8(SKIN_SHUF_B0, SKIN_SHUF_B0), b1 = _mm256_setr_epi8(SKIN_SHUF_B1, SKIN_SHUF_B1), b2 = _mm256_setr_epi8(SKIN_SHUF_B2, SKIN_SHUF_B2);
+	const __m256i g0 = _mm256_setr_epi8(SKIN_SHUF_G0, SKIN_SHUF_G0), g1 = _mm256_setr_epi8(SKIN_SHUF_G1, SKIN_SHUF_G1), g2 = _mm256_setr_epi8(SKIN_SHUF_G2, SKIN_SHUF_G2);
+	const __m256i r0 = _mm256_setr_epi8(SKIN_SHUF_R0, SKIN_SHUF_R0), r1 = _mm256_setr_epi8(SKIN_SHUF_R1, SKIN_SHUF_R1), r2 = _mm256_setr_epi8(SKIN_SHUF_R2, SKIN_SHUF_R2);
+	const __m256i c95 = _mm256_set1_epi8(95), c40 = _mm256_set1_epi8(40), c20 = _mm256_set1_epi8(20), c15 = _mm256_set1_epi8(15);
+
+	__m256i v0 = skinLoadPair(bgr);
+	__m256i v1 = skinLoadPair(bgr + 16);
+	__m256i v2 = skinLoadPair(bgr + 32);
+	__m256i B = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, b0), _mm256_shuffle_epi8(v1, b1)), _mm256_shuffle_epi8(v2, b2));
+	__m256i G = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, g0), _mm256_shuffle_epi8(v1, g1)), _mm256_shuffle_epi8(v2, g2));
+	__m256i R = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, r0), _mm256_shuffle_epi8(v1, r1)), _mm256_shuffle_epi8(v2, r2));
+
+	__m256i t = _mm256_min_epu8(_mm256_subs_epu8(R, c95), _mm256_subs_epu8(G, c40));
+	t = _mm256_min_epu8(t, _mm256_subs_epu8(B, c20));
+	t = _mm256_min_epu8(t, _mm256_subs_epu8(R, B));
+	t = _mm256_min_epu8(t, _mm256_subs_epu8(_mm256_subs_epu8(R, G), c15));
+	return _mm256_cmpeq_epi8(t, _mm256_setzero_si256());
+}
+
+//Function that classifies 32 pixels per step with AVX2
+SKIN_TARGET_AVX2
+static void skinDetectRowAVX2(const unsigned char* bgr, unsigned char* mask, int width) {
+	const __m256i ones = _mm256_set1_epi8(-1);
+	int j = 0;
+	for (; j + 32 <= width; j += 32, bgr += 96){
+		_mm256_storeu_si256((__m256i*)(mask + j), _mm256_xor_si256(skinRejectAVX2(bgr), ones));
+	}
+	skinDetectRowSSSE3(bgr, mask + j, width - j);
+}
+
+//Function that packs 64 pixels per word with AVX2 (two steps of 32)
+SKIN_TARGET_AVX2
+static void skinDetectRowBitsAVX2(const unsigned char* bgr, unsigned long long* bits, int width) {
+	int j = 0;
+	for (; j + 64 <= width; j += 64, bgr += 192){
+		unsigned long long lo = (unsigned)~_mm256_movemask_epi8(skinRejectAVX2(bgr));
+		unsigned long long hi = (unsigned)~_mm256_movemask_epi8(skinRejectAVX2(bgr + 96));
+		bits[j >> 6] = lo | (hi << 32);
+	}
+	skinDetectRowBitsSSSE3(bgr, bits + (j >> 6), width - j);
+}
+
+static bool cpuHasSSSE3() {
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuid(r, 1);
+	return (r[2] & (1 << 9)) != 0;
+#else
+	return __builtin_cpu_supports("ssse3") != 0;
+#endif
+}
+
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuid(r, 0);
+	if (r[0] < 7) return false;
+	__cpuid(r, 1);
+	//the OS has to save the YMM registers (OSXSAVE + AVX, then XCR0 bits 1 and 2)
+	if ((r[2] & (1 << 27)) == 0 || (r[2] & (1 << 28)) == 0) return false;
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(r, 7, 0);
+	return (r[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // SKIN_X86
+
+typedef void(*SkinRowFn)(const unsigned char*, unsigned char*, int);
+typedef void(*SkinBitsFn)(const unsigned char*, unsigned long long*, int);
+
+struct SkinKernel {
+	SkinRowFn fn;
+	SkinBitsFn bitsFn;
+	const char* name;
+};
+
+//Function that looks up a kernel by name, returns false if the running CPU does not support it
+static bool findSkinKernel(const char* name, SkinKernel& k) {
+	if (strcmp(name, "scalar") == 0) {
+		k.fn = skinDetectRowScalar; k.bitsFn = skinDetectRowBitsScalar; k.name = "scalar";
+		return true;
+	}
+#ifdef SKIN_X86
+	if (strcmp(name, "avx2") == 0 && cpuHasAVX2()) {
+		k.fn = skinDetectRowAVX2; k.bitsFn = skinDetectRowBitsAVX2; k.name = "avx2";
+		return true;
+	}
+	if (strcmp(name, "ssse3") == 0 && cpuHasSSSE3()) {
+		k.fn = skinDetectRowSSSE3; k.bitsFn = skinDetectRowBitsSSSE3; k.name = "ssse3";
+		return true;
+	}
+#endif
+	return false;
+}
+
+static SkinKernel selectSkinKernel() {
+	SkinKernel k;
+#if defined(SKIN_X86) && !defined(_MSC_VER)
+	//this runs from a static initializer, possibly before libgcc has filled in its CPU model
+	__builtin_cpu_init();
+#endif
+	if (!findSkinKernel("avx2", k) && !findSkinKernel("ssse3", k)) {
+		findSkinKernel("scalar", k);
+	}
+	return k;
+}
+
+//Picked once during static initialization, before main runs
+static const SkinKernel g_skinKernel = selectSkinKernel();
+
+void skinDetectRow(const unsigned char* bgr, unsigned char* mask, int width) {
+	g_skinKernel.fn(bgr, mask, width);
+}
+
+void skinDetectRowBits(const unsigned char* bgr, unsigned long long* bits, int width) {
+	g_skinKernel.bitsFn(bgr, bits, width);
+}
+
+const char* skinDetectKernelName() {
+	return g_skinKernel.name;
+}
+
+bool skinDetectRowWith(const char* kernel, const unsigned char* bgr, unsigned char* mask, int width) {
+	SkinKernel k;
+	if (!findSkinKernel(kernel, k)) {
+		return false;
+	}
+	k.fn(bgr, mask, width);
+	return true;
+}
+
+bool skinDetectRowBitsWith(const char* kernel, const unsigned char* bgr, unsigned long long* bits, int width) {
+	SkinKernel k;
+	if (!findSkinKernel(kernel, k)) {
+		return false;
+	}
+	k.bitsFn(bgr, bits, width);
+	return true;
+}
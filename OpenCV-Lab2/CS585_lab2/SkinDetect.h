@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+SkinDetect.h
+
+Row kernels for the RGB skin rule used by mySkinDetect.
+The rule is evaluated on 32 (AVX2) or 16 (SSSE3) pixels at a time and the mask is written without branches,
+either as one byte per pixel or packed to one bit per pixel.
+The widest instruction set supported by the running CPU is picked once at startup, with a scalar fallback.
+*/
+
+/**
+Function that classifies one row of BGR pixels as skin / not skin
+@param bgr Pointer to the first pixel of the source row (3 bytes per pixel, in B, G, R order)
+@param mask Pointer to the first byte of the destination row; skin pixels are set to 255 and the rest to 0
+@param width Number of pixels in the row
+*/
+void skinDetectRow(const unsigned char* bgr, unsigned char* mask, int width);
+
+/**
+Scalar version of skinDetectRow, always available; used as the fallback and as the reference for the SIMD kernels
+@param bgr Pointer to the first pixel of the source row (3 bytes per pixel, in B, G, R order)
+@param mask Pointer to the first byte of the destination row; skin pixels are set to 255 and the rest to 0
+@param width Number of pixels in the row
+*/
+void skinDetectRowScalar(const unsigned char* bgr, unsigned char* mask, int width);
+
+/**
+Function that classifies one row of BGR pixels into a bit-packed mask (see BitMask.h)
+@param bgr Pointer to the first pixel of the source row (3 bytes per pixel, in B, G, R order)
+@param bits Pointer to the first word of the destination row; bit j % 64 of word j / 64 is pixel j, the bits past width are cleared
+@param width Number of pixels in the row
+*/
+void skinDetectRowBits(const unsigned char* bgr, unsigned long long* bits, int width);
+
+/**
+Scalar version of skinDetectRowBits
+@param bgr Pointer to the first pixel of the source row (3 bytes per pixel, in B, G, R order)
+@param bits Pointer to the first word of the destination row
+@param width Number of pixels in the row
+*/
+void skinDetectRowBitsScalar(const unsigned char* bgr, unsigned long long* bits, int width);
+
+/**
+Function that returns the name of the kernel picked at startup ("avx2", "ssse3" or "scalar")
+*/
+const char* skinDetectKernelName();
+
+/**
+Function that classifies one row with a given kernel instead of the one picked at startup (for the tests),
+returns false without touching the mask when the running CPU does not support that kernel
+@param kernel "avx2", "ssse3" or "scalar"
+@param bgr Pointer to the first pixel of the source row
+@param mask Pointer to the first byte of the destination row
+@param width Number of pixels in the row
+*/
+bool skinDetectRowWith(const char* kernel, const unsigned char* bgr, unsigned char* mask, int width);
+
+/**
+Function that classifies one row into a bit-packed mask with a given kernel, as skinDetectRowWith
+@param kernel "avx2", "ssse3" or "scalar"
+@param bgr Pointer to the first pixel of the source row
+@param bits Pointer to the first word of the destination row
+@param width Number of pixels in the row
+*/
+bool skinDetectRowBitsWith(const char* kernel, const unsigned char* bgr, unsigned long long* bits, int width);
@@ -0,0 +1,101 @@
+#include "SkinGate.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace cv;
+
+static const int GATE_BLOCK = 8;
+
+SkinGate::SkinGate(int size, double density)
+	: m_size(std::max(0, size)), m_density(std::min(1.0, std::max(0.0, density))), m_blockCols(0), m_rejected(0)
+{
+}
+
+SkinGate::SkinGate(const SkinGate& other)
+	: m_size(other.m_size), m_density(other.m_density), m_mask(other.m_mask), m_blockCols(other.m_blockCols),
+	m_rowCounts(other.m_rowCounts), m_integral(other.m_integral), m_rejected(other.rejected())
+{
+}
+
+SkinGate& SkinGate::operator=(const SkinGate& other)
+{
+	// written by hand only because the counter is atomic
+	m_size = other.m_size;
+	m_density = other.m_density;
+	m_mask = other.m_mask;
+	m_blockCols = other.m_blockCols;
+	m_rowCounts = other.m_rowCounts;
+	m_integral = other.m_integral;
+	m_rejected = other.rejected();
+	return *this;
+}
+
+void SkinGate::reset(Size size)
+{
+	m_mask = size;
+	m_blockCols = (size.width + GATE_BLOCK - 1) / GATE_BLOCK;
+	// every row is written by countRow, so the counts need no clearing
+	m_rowCounts.resize((size_t)size.height * m_blockCols);
+}
+
+void SkinGate::countRow(int row, const unsigned char* mask)
+{
+	unsigned char* counts = &m_rowCounts[(size_t)row * m_blockCols];
+	int full = m_mask.width / GATE_BLOCK;
+	for (int b = 0; b < full; b++, mask += GATE_BLOCK) {
+		// 8 mask bytes of 0 or 255: one bit of each byte counts them
+		unsigned long long w;
+		std::memcpy(&w, mask, sizeof(w));
+		w &= 0x0101010101010101ULL;
+		counts[b] = (unsigned char)((w * 0x0101010101010101ULL) >> 56);
+	}
+	if (full < m_blockCols) {
+		int n = 0;
+		for (int j = full * GATE_BLOCK; j < m_mask.width; j++, mask++) {
+			n += *mask & 1;
+		}
+		counts[full] = (unsigned char)n;
+	}
+}
+
+bool SkinGate::anyCandidate(int scale)
+{
+	if (!enabled()) {
+		return true;
+	}
+	int blockRows = (m_mask.height + GATE_BLOCK - 1) / GATE_BLOCK;
+	int stride = m_blockCols + 1;
+	m_integral.assign((size_t)(blockRows + 1) * stride, 0);
+	for (int by = 0; by < blockRows; by++) {
+		int* above = &m_integral[(size_t)by * stride];
+		int* sat = above + stride;
+		int rowSum = 0;
+		int yEnd = std::min(m_mask.height, (by + 1) * GATE_BLOCK);
+		for (int bx = 0; bx < m_blockCols; bx++) {
+			const unsigned char* c = &m_rowCounts[(size_t)by * GATE_BLOCK * m_blockCols + bx];
+			for (int y = by * GATE_BLOCK; y < yEnd; y++, c += m_blockCols) {
+				rowSum += *c;
+			}
+			sat[bx + 1] = above[bx + 1] + rowSum;
+		}
+	}
+
+	// the square, in whole blocks (at least one), and no larger than the mask
+	int side = std::max(1, m_size / std::max(1, scale) / GATE_BLOCK);
+	int wx = std::min(side, m_blockCols), wy = std::min(side, blockRows);
+	for (int by = 0; by + wy <= blockRows; by++) {
+		const int* top = &m_integral[(size_t)by * stride];
+		const int* bottom = top + (size_t)wy * stride;
+		int height = std::min(m_mask.height, (by + wy) * GATE_BLOCK) - by * GATE_BLOCK;
+		for (int bx = 0; bx + wx <= m_blockCols; bx++) {
+			int skin = bottom[bx + wx] - bottom[bx] - top[bx + wx] + top[bx];
+			int width = std::min(m_mask.width, (bx + wx) * GATE_BLOCK) - bx * GATE_BLOCK;
+			if (skin > 0 && skin >= m_density * width * height) {
+				return true;
+			}
+		}
+	}
+	m_rejected.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <atomic>
+#include <vector>
+
+/**
+SkinGate.h
+
+Early "no hand" test on the skin mask. While the skin detection writes a row, the skin pixels of the row are counted
+per block of 8 columns (8 bytes of the mask at a time); the rows are then summed into a grid of 8x8 blocks and a
+summed-area table of that grid gives the skin count of any window of blocks in four reads.
+A hand can only be present if some square of at least `size` pixels is at least `density` skin; when none is,
+the blob extraction, contour, hull and classification are skipped and the frame costs little more than the skin pass.
+*/
+class SkinGate {
+public:
+	/**
+	@param size Side of the smallest square, in pixels, that a hand has to fill; 0 disables the gate
+	@param density Share of skin pixels the square needs, in (0, 1]
+	*/
+	explicit SkinGate(int size = 32, double density = 0.5);
+	SkinGate(const SkinGate& other);
+	SkinGate& operator=(const SkinGate& other);
+
+	/**
+	Function that tells whether the gate is enabled
+	*/
+	bool enabled() const { return m_size > 0; }
+
+	/**
+	Prepares the counts of a mask (the buffers are reused from one frame to the next)
+	@param size Size of the skin mask that will be counted
+	*/
+	void reset(cv::Size size);
+
+	/**
+	Counts the skin pixels of one mask row per block of 8 columns. Rows may be counted from several threads at once
+	@param row Number of the row in the mask
+	@param mask Pointer to the first byte of the row, 255 for skin and 0 elsewhere
+	*/
+	void countRow(int row, const unsigned char* mask);
+
+	/**
+	Function that returns true if some square of the counted mask passes the size and density test
+	@param scale Working scale of the mask: the square side is divided by it
+	*/
+	bool anyCandidate(int scale = 1);
+
+	/**
+	Function that returns the number of frames the gate rejected. May be called from another thread
+	*/
+	unsigned long long rejected() const { return m_rejected.load(std::memory_order_relaxed); }
+
+private:
+	int m_size;
+	double m_density;
+	cv::Size m_mask;
+	int m_blockCols;
+	std::vector<unsigned char> m_rowCounts;	// skin pixels of each row in each block column
+	std::vector<int> m_integral;			// summed-area table of the block counts, (blockRows + 1) x (blockCols + 1)
+	std::atomic<unsigned long long> m_rejected;	// read by the thread that reports the stats
+};
@@ -0,0 +1,142 @@
+#include "SkinModel.h"
+#include "SkinDetect.h"
+
+#include <vector>
+
+using namespace cv;
+
+//The rule of mySkinDetect (see SkinDetect.cpp)
+struct RgbRule {
+	static constexpr bool contains(int b, int g, int r)
+	{
+		return r > 95 && g > 40 && b > 20 && r > b && r - g > 15;
+	}
+};
+
+//Box in the CrCb plane (Chai and Ngan): 133 <= Cr <= 173, 77 <= Cb <= 127, with the integer BT.601 weights of cvtColor
+struct YCrCbRule {
+	static constexpr bool contains(int b, int g, int r)
+	{
+		return inBox(((r * 4899 + g * 9617 + b * 1868) + (1 << 13)) >> 14, r, b);
+	}
+	static constexpr bool inBox(int y, int r, int b)
+	{
+		//the offset keeps the numerator positive before the shift
+		return inRange((((r - y) * 11682 + (1 << 13) + (256 << 14)) >> 14) - 128, 133, 173)
+			&& inRange((((b - y) * 9241 + (1 << 13) + (256 << 14)) >> 14) - 128, 77, 127);
+	}
+	static constexpr bool inRange(int v, int lo, int hi)
+	{
+		return v >= lo && v <= hi;
+	}
+};
+
+//Hue between 0 and 50 degrees and saturation between 0.23 and 0.68 (Sobottka and Pitas), in integer form:
+//R is the largest channel, 0 <= 60 * (G - B) <= 50 * (max - min) and 23 * max <= 100 * (max - min) <= 68 * max
+struct HsvRule {
+	static constexpr bool contains(int b, int g, int r)
+	{
+		return r >= g && g >= b && r > 0 && 60 * (g - b) <= 50 * (r - b) && 100 * (r - b) >= 23 * r && 100 * (r - b) <= 68 * r;
+	}
+};
+
+//each table takes a few million evaluation steps: MSVC needs /constexpr:steps (set in the project and in CMakeLists.txt)
+static constexpr SkinLut g_rgbLut = makeSkinLut<RgbRule>();
+static constexpr SkinLut g_ycrcbLut = makeSkinLut<YCrCbRule>();
+static constexpr SkinLut g_hsvLut = makeSkinLut<HsvRule>();
+
+static_assert(g_rgbLut.contains(90, 120, 200) && !g_rgbLut.contains(0, 0, 0), "RGB skin table");
+static_assert(g_ycrcbLut.contains(90, 120, 200) && !g_ycrcbLut.contains(255, 0, 0), "YCrCb skin table");
+static_assert(g_hsvLut.contains(90, 120, 200) && !g_hsvLut.contains(0, 200, 0), "HSV skin table");
+
+SkinModel::SkinModel()
+	: m_lut(&g_rgbLut), m_exactRgb(true), m_name("rgb")
+{
+}
+
+SkinModel::SkinModel(const SkinLut* lut, std::shared_ptr<SkinLut> owned, bool exactRgb, const std::string& name)
+	: m_lut(lut), m_owned(owned), m_exactRgb(exactRgb), m_name(name)
+{
+}
+
+bool SkinModel::byName(const std::string& name, SkinModel& model)
+{
+	if (name == "rgb") {
+		model = SkinModel();
+	}
+	else if (name == "ycrcb") {
+		model = SkinModel(&g_ycrcbLut, std::shared_ptr<SkinLut>(), false, name);
+	}
+	else if (name == "hsv") {
+		model = SkinModel(&g_hsvLut, std::shared_ptr<SkinLut>(), false, name);
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+SkinModel SkinModel::fromSamples(const Mat& image, const Mat& mask, double theta)
+{
+	std::vector<unsigned> skin(SKIN_LUT_CELLS, 0), other(SKIN_LUT_CELLS, 0);
+	double skinTotal = 0, otherTotal = 0;
+	for (int i = 0; i < image.rows; i++) {
+		const uchar* p = image.ptr<uchar>(i);
+		const uchar* m = mask.empty() ? 0 : mask.ptr<uchar>(i);
+		for (int j = 0; j < image.cols; j++, p += 3) {
+			int c = SkinLut::cell(p[0], p[1], p[2]);
+			bool isSkin = m ? m[j] != 0 : (p[0] | p[1] | p[2]) != 0;
+			if (isSkin) {
+				skin[c]++;
+				skinTotal++;
+			}
+			else if (m) {
+				other[c]++;
+				otherTotal++;
+			}
+		}
+	}
+
+	std::shared_ptr<SkinLut> lut = std::make_shared<SkinLut>();
+	*lut = SkinLut();
+	for (int c = 0; c < SKIN_LUT_CELLS && skinTotal > 0; c++) {
+		//without labelled non-skin pixels every color is equally likely to be background
+		double pOther = otherTotal > 0 ? other[c] / otherTotal : 1.0 / SKIN_LUT_CELLS;
+		if (skin[c] / skinTotal > theta * pOther) {
+			lut->words[c >> 6] |= 1ULL << (c & 63);
+		}
+	}
+	return SkinModel(lut.get(), lut, false, "histogram");
+}
+
+void SkinModel::classifyRow(const unsigned char* bgr, unsigned char* mask, int width) const
+{
+	if (m_exactRgb) {
+		//the arithmetic SIMD kernel is exact and faster than a per-pixel lookup for this rule
+		skinDetectRow(bgr, mask, width);
+		return;
+	}
+	const unsigned long long* words = m_lut->words;
+	for (int j = 0; j < width; j++, bgr += 3) {
+		int c = SkinLut::cell(bgr[0], bgr[1], bgr[2]);
+		mask[j] = (unsigned char)-(int)((words[c >> 6] >> (c & 63)) & 1);
+	}
+}
+
+void SkinModel::classifyRowBits(const unsigned char* bgr, unsigned long long* bits, int width) const
+{
+	if (m_exactRgb) {
+		skinDetectRowBits(bgr, bits, width);
+		return;
+	}
+	const unsigned long long* words = m_lut->words;
+	for (int j = 0; j < width; j += 64) {
+		unsigned long long w = 0;
+		int n = width - j < 64 ? width - j : 64;
+		for (int k = 0; k < n; k++, bgr += 3) {
+			int c = SkinLut::cell(bgr[0], bgr[1], bgr[2]);
+			w |= ((words[c >> 6] >> (c & 63)) & 1) << k;
+		}
+		bits[j >> 6] = w;
+	}
+}
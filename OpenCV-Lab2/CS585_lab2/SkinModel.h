@@ -0,0 +1,124 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <memory>
+#include <string>
+
+/**
+SkinModel.h
+
+Pluggable skin-color models. Every model is baked into a quantized 3D lookup table with one bit per color cell
+(32 levels per channel, 32^3 bits = 4 KB, small enough to stay in the L1 cache), so classifying a pixel is one
+table lookup whatever the model. The fixed rules (RGB, YCrCb box, HSV range) are generated as constexpr tables at
+compile time; histogram (Bayes) models are built from labelled samples when they are loaded.
+*/
+
+// levels per channel in the table and the shift from 8 bit values to a level
+const int SKIN_LUT_SHIFT = 3;
+const int SKIN_LUT_LEVELS = 256 >> SKIN_LUT_SHIFT;
+const int SKIN_LUT_CELLS = SKIN_LUT_LEVELS * SKIN_LUT_LEVELS * SKIN_LUT_LEVELS;
+
+/**
+One bit per quantized BGR cell, set when the cell is skin
+*/
+struct SkinLut {
+	unsigned long long words[SKIN_LUT_CELLS / 64];
+
+	/**
+	Function that returns the index of the cell of a color
+	*/
+	static constexpr int cell(int b, int g, int r)
+	{
+		return ((r >> SKIN_LUT_SHIFT) << (2 * (8 - SKIN_LUT_SHIFT))) | ((g >> SKIN_LUT_SHIFT) << (8 - SKIN_LUT_SHIFT)) | (b >> SKIN_LUT_SHIFT);
+	}
+
+	/**
+	Function that tells whether a color is in a skin cell
+	*/
+	constexpr bool contains(int b, int g, int r) const
+	{
+		return ((words[cell(b, g, r) >> 6] >> (cell(b, g, r) & 63)) & 1) != 0;
+	}
+};
+
+/**
+Function that bakes a fixed rule into a table; usable in constant expressions.
+Each cell takes the value of the rule at its center color
+@param Rule A type with a static constexpr bool contains(int b, int g, int r)
+*/
+template<typename Rule>
+constexpr SkinLut makeSkinLut()
+{
+	SkinLut lut = {};
+	const int half = 1 << (SKIN_LUT_SHIFT - 1);
+	for (int r = 0; r < SKIN_LUT_LEVELS; r++) {
+		for (int g = 0; g < SKIN_LUT_LEVELS; g++) {
+			for (int b = 0; b < SKIN_LUT_LEVELS; b++) {
+				if (Rule::contains((b << SKIN_LUT_SHIFT) + half, (g << SKIN_LUT_SHIFT) + half, (r << SKIN_LUT_SHIFT) + half)) {
+					int i = (r << (2 * (8 - SKIN_LUT_SHIFT))) | (g << (8 - SKIN_LUT_SHIFT)) | b;
+					lut.words[i >> 6] |= 1ULL << (i & 63);
+				}
+			}
+		}
+	}
+	return lut;
+}
+
+class SkinModel {
+public:
+	/**
+	The RGB rule of mySkinDetect
+	*/
+	SkinModel();
+
+	/**
+	Function that selects one of the built-in models by name ("rgb", "ycrcb" or "hsv"), returns false if there is none
+	@param name The name given on the command line
+	@param model Receives the model
+	*/
+	static bool byName(const std::string& name, SkinModel& model);
+
+	/**
+	Function that trains a histogram model: a color is skin when P(color | skin) > theta * P(color | not skin)
+	@param image Training image (BGR)
+	@param mask Labels of the training image: non-zero is skin. When empty, the non-black pixels of the image are skin
+	and the non-skin colors are taken as uniformly distributed
+	@param theta Decision threshold on the likelihood ratio; larger values give fewer false positives
+	*/
+	static SkinModel fromSamples(const cv::Mat& image, const cv::Mat& mask, double theta = 1.0);
+
+	/**
+	Function that classifies one row of BGR pixels, writing 255 for skin and 0 for the rest
+	@param bgr Pointer to the first pixel of the row (3 bytes per pixel)
+	@param mask Pointer to the first byte of the destination row
+	@param width Number of pixels in the row
+	*/
+	void classifyRow(const unsigned char* bgr, unsigned char* mask, int width) const;
+
+	/**
+	Function that classifies one row of BGR pixels into a bit-packed mask (see BitMask.h)
+	@param bgr Pointer to the first pixel of the row (3 bytes per pixel)
+	@param bits Pointer to the first word of the destination row; the bits past width are cleared
+	@param width Number of pixels in the row
+	*/
+	void classifyRowBits(const unsigned char* bgr, unsigned long long* bits, int width) const;
+
+	/**
+	Function that returns the table of the model
+	*/
+	const SkinLut& lut() const { return *m_lut; }
+
+	/**
+	Function that returns the name of the model
+	*/
+	const std::string& name() const { return m_name; }
+
+private:
+	SkinModel(const SkinLut* lut, std::shared_ptr<SkinLut> owned, bool exactRgb, const std::string& name);
+
+	const SkinLut* m_lut;				// the compile-time table, or m_owned
+	std::shared_ptr<SkinLut> m_owned;	// table built at load time, shared between copies
+	bool m_exactRgb;					// the RGB rule runs the exact SIMD kernel of SkinDetect.h instead of the table
+	std::string m_name;
+};
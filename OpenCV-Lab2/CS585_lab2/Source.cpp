@@ -1,331 +1,676 @@
 #include "opencv2/core/core.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "AllocCounter.h"
+#include "BackgroundModel.h"
+#include "BandExecutor.h"
+#include "DeadlineScheduler.h"
+#include "FrameInput.h"
+#include "FramePipeline.h"
+#include "GestureEngine.h"
+#include "GestureEvents.h"
+#include "GestureLog.h"
+#include "HandAnalysis.h"
+#include "ImageKernels.h"
+#include "MotionHistory.h"
+#include "Options.h"
+#include "RawVideo.h"
+#include "RoiTracker.h"
+#include "StageProfiler.h"
+#include "StreamEngine.h"
+
 
 using namespace cv;
 using namespace std;
 
 /**
-Function that returns the maximum of 3 integers
-@param a first integer
-@param b second integer
-@param c third integer
+Function that converts a difference of cv::getTickCount() values to milliseconds
+@param ticks Number of ticks
 */
-int myMax(int a, int b, int c);
+double myTicksToMs(long long ticks);
 
 /**
-Function that returns the minimum of 3 integers
-@param a first integer
-@param b second integer
-@param c third integer
+Function that prints the pipeline counters and the per-stage timing summary, and rewrites the stats file if one is given
+@param pipeline The running pipeline
+@param lastAllocations Heap allocations of the analysis stage for the last frame (debug builds)
+@param statsFile Name of the JSON stats file, empty for none
+@param scheduler The frame scheduler, whose levels are reported when a deadline is set
+@param gate The "no hand" gate of the analysis, whose rejections are reported when it is enabled
 */
-int myMin(int a, int b, int c);
+void myReportStats(const FramePipeline& pipeline, unsigned long long lastAllocations, const string& statsFile, const DeadlineScheduler& scheduler,
+	const SkinGate& gate);
 
 /**
-Function that detects whether a pixel belongs to the skin based on RGB values
-@param src The source color image
-@param dst The destination grayscale image where skin pixels are colored white and the rest are colored black
+Function that prints how many frames ran at each level of a frame scheduler, if it has a deadline
+@param scheduler The scheduler
 */
-void mySkinDetect(Mat& src, Mat& dst);
+void myReportLevels(const DeadlineScheduler& scheduler);
 
 /**
-Function that does frame differencing between the current frame and the previous frame
-@param src The current color image
-@param prev The previous color image
-@param dst The destination grayscale image where pixels are colored white if the corresponding pixel intensities in the current
-and previous image are not the same
+Function that prints how many frames the "no hand" gate rejected, if it is enabled
+@param gate The gate
 */
-void myFrameDifferencing(Mat& prev, Mat& curr, Mat& dst);
+void myReportGate(const SkinGate& gate);
 
 /**
-Function that accumulates the frame differences for a certain number of pairs of frames
-@param mh Vector of frame difference images
-@param dst The destination grayscale image to store the accumulation of the frame difference images
+Function that runs the headless analysis of several streams in one process on a shared work-stealing pool, returns the exit code
+@param opts The command line switches
+@param inputs The streams: camera numbers, video files or directories of images
+@param scratch Analysis settings copied into the state of every stream
+@param motion true to run the background subtraction and motion history on every frame
+@param background Background model settings copied into every stream
+@param motionHistory Motion history settings copied into every stream
+@param temporal Settings of the gesture state machine of every stream
 */
-void myMotionEnergy(vector<Mat> mh, Mat& dst);
+int myRunStreams(const Options& opts, const vector<string>& inputs, const HandScratch& scratch,
+	bool motion, const BackgroundModel& background, const MotionHistory& motionHistory, const TemporalConfig& temporal);
 
+/**
+Function that prints the counters of every stream and the per-stage timing summary, and rewrites the stats file if one is given
+@param engine The running engine
+@param statsFile Name of the JSON stats file, empty for none
+@param schedulers The frame scheduler of every stream
+@param gates The "no hand" gate of every stream
+*/
+void myReportStreamStats(const StreamEngine& engine, const string& statsFile, const vector<const DeadlineScheduler*>& schedulers,
+	const vector<const SkinGate*>& gates);
 
 /**
-Function that does some sort of detection of the three image processing
-**/
-void condefects(vector<Vec4i> convexityDefectsSet, vector<Point> mycontour, Mat &frame);
+Function that reads the next frame of a source and appends it to a raw recording when one is open, returns false at the end of the source
+@param input The source
+@param recorder The recording; it is closed if a frame cannot be written
+@param frame Receives the frame
+*/
+bool myReadAndRecord(FrameInput& input, RawRecorder& recorder, Mat& frame);
 
+/**
+Function that splits a comma-separated list
+@param list The list
+*/
+vector<string> mySplitList(const string& list);
 
-/** Global Varialbes **/
-int thresh = 128;
-int max_thresh = 255;
+/**
+Function that inserts a stream number before the extension of a file name: gestures.csv -> gestures_1.csv
+@param file The file name
+@param stream The stream number
+*/
+string myStreamFileName(const string& file, size_t stream);
+
+/**
+Function that takes the queued gesture events, writes them to a file and prints them
+@param machine The state machine that queued them
+@param file The JSON lines destination, or NULL for none
+@param print true to also print them
+*/
+void myDrainEvents(GestureStateMachine& machine, ostream* file, bool print);
 
 
 /** Main Function **/
-int main()
+int main(int argc, char** argv)
 {
+	// command line switches: threads=N caps the number of cores used by the pixel kernels, band=H sets the rows per band
+	Options opts(argc, argv);
+	BandExecutor::configureShared(opts.getInt("threads", 0), opts.getInt("band", 0));
+
+	// headless=1 runs without any window and writes one record per frame to output=FILE (.csv or .jsonl);
+	// input=PATH reads a video file, a directory of images or another camera number instead of camera 0.
+	// Several comma-separated inputs are analysed together in one process (headless)
+	bool headless = opts.getInt("headless", 0) != 0;
+	string input = opts.get("input");
+	vector<string> inputs = mySplitList(input);
 
 	//----------------
 	//a) Reading a stream of images from a webcamera, and displaying the video
 	//----------------
-	// open the video camera no. 0
-	VideoCapture cap(0);
+	FrameInput cap;
+	// record=FILE appends every captured frame, as it was captured, to a raw recording that input=FILE replays bit-exactly
+	RawRecorder recorder;
+	FramePipeline::FrameSource source = [&cap, &recorder](Mat& frame) { return myReadAndRecord(cap, recorder, frame); };
 
 	// if not successful, exit program
-	if (!cap.isOpened())
+	if (inputs.size() <= 1 && !cap.open(input))
 	{
-		cout << "Cannot open the video cam" << endl;
+		cout << "Cannot open " << (input.empty() ? string("the video cam") : input) << endl;
 		return -1;
 	}
-
-	//create a window called "MyVideoFrame0"
-	namedWindow("MyVideo0", WINDOW_AUTOSIZE);
-	Mat frame0; //what is the Mat datatype
-
-	// read a new frame from video
-	bool bSuccess0 = cap.read(frame0);
-
-	//if not successful, break loop
-	if (!bSuccess0)
+	if (inputs.size() <= 1 && opts.has("record") && !recorder.open(opts.get("record")))
 	{
-		cout << "Cannot read a frame from video stream" << endl;//how are you breaking the loop
+		cout << "Cannot open " << opts.get("record") << endl;
+		return -1;
 	}
 
-	//show the frame in "MyVideo" window
-	imshow("MyVideo0", frame0);
+	// windows=result,skin,motion picks the windows that are shown (the motion windows only with motion=1)
+	vector<string> windows = mySplitList(opts.get("windows", "result,skin,motion"));
+	bool showResult = find(windows.begin(), windows.end(), "result") != windows.end();
+	bool showSkin = find(windows.begin(), windows.end(), "skin") != windows.end();
+	bool showMotion = find(windows.begin(), windows.end(), "motion") != windows.end() && opts.getInt("motion", 0) != 0;
 
-	//create a window called "MyVideo", "MyVideoMH", and "Skin"
-	namedWindow("MyVideo", WINDOW_AUTOSIZE);
-	namedWindow("MyVideoMH", WINDOW_AUTOSIZE);
-	namedWindow("Skin", WINDOW_AUTOSIZE);
-	namedWindow("RockScissorPaper", WINDOW_AUTOSIZE);
+	if (!headless && inputs.size() <= 1)
+	{
+		//create a window called "MyVideoFrame0"; it shows the first frame out of the pipeline, which is analysed
+		//and logged like the others
+		namedWindow("MyVideo0", WINDOW_AUTOSIZE);
 
+		//create a window called "MyVideo", "MyVideoMH", and "Skin"
+		if (showMotion)
+		{
+			namedWindow("MyVideo", WINDOW_AUTOSIZE);
+			namedWindow("MyVideoMH", WINDOW_AUTOSIZE);
+		}
+		if (showSkin)
+		{
+			namedWindow("Skin", WINDOW_AUTOSIZE);
+		}
+		if (showResult)
+		{
+			namedWindow("RockScissorPaper", WINDOW_AUTOSIZE);
+		}
+	}
 
-	vector<Mat> myMotionHistory;
-	Mat fMH1, fMH2, fMH3;
-	fMH1 = Mat::zeros(frame0.rows, frame0.cols, CV_8UC1);
-	fMH2 = fMH1.clone();
-	fMH3 = fMH1.clone();
-	myMotionHistory.push_back(fMH1);
-	myMotionHistory.push_back(fMH2);
-	myMotionHistory.push_back(fMH3);
 
-	while (1)
+	//----------------
+	//	c) Background differencing and d) motion history, enabled with motion=1
+	//----------------
+	// background=previous|average|median picks the background model and alpha=A its learning rate;
+	// a pixel counts as moving when its gray level differs from the background by more than motion_threshold=T
+	bool motion = opts.getInt("motion", 0) != 0;
+	BackgroundModel::Mode backgroundMode = BackgroundModel::RUNNING_AVERAGE;
+	if (opts.has("background") && !BackgroundModel::parseMode(opts.get("background"), backgroundMode))
 	{
-		// read a new frame from video
-		Mat frame;
-		bool bSuccess = cap.read(frame);
+		cout << "Unknown background model " << opts.get("background") << ", using average" << endl;
+	}
+	BackgroundModel background(backgroundMode, opts.getDouble("alpha", 0.05), opts.getInt("motion_threshold", 50));
+	// motion history over the last history=K frames: one timestamp per pixel instead of K masks
+	MotionHistory motionHistory(opts.getInt("history", 3));
 
-		//if not successful, break loop
-		if (!bSuccess)
+	//----------------
+	//	The loop runs as a pipeline: a capture thread reads frames, an analysis thread runs myAnalyzeFrame on them,
+	//	and this thread only displays the results, so camera I/O, analysis and waitKey overlap instead of adding up
+	//----------------
+	HandScratch scratch;
+	// skin model, tracking and coarse-to-fine switches (see myConfigureHand)
+	myConfigureHand(opts, scratch, cout);
+	// the analysis never draws: it copies what the overlays need and this thread draws them on the frames it shows,
+	// so the analysis of the next frame does not wait for the drawing, and frames that are not shown cost nothing
+	scratch.draw = false;
+	bool overlays = !headless && (showResult || showSkin);
+	// deadline=MS keeps the time from capture to presentation under MS milliseconds by dropping the overlays, then the motion
+	// stage, of frames that would miss it, and skipping frames that already have; recover=N frames with room to spare bring
+	// back one stage (see DeadlineScheduler.h)
+	DeadlineScheduler scheduler(opts.getDouble("deadline", 0), opts.getInt("recover", 8));
+	// gesture events: the gesture is voted over the last frames and swipes and waves are found in the trajectory of the hand
+	// (see GestureEvents.h for the switches); events=FILE writes them as JSON lines
+	TemporalConfig temporal;
+	myConfigureEvents(opts, temporal);
+	if (inputs.size() > 1)
+	{
+		return myRunStreams(opts, inputs, scratch, motion, background, motionHistory, temporal);
+	}
+	GestureStateMachine events(temporal);
+	ofstream eventsFile;
+	string eventsName = opts.get("events");
+	if (!eventsName.empty())
+	{
+		eventsFile.open(eventsName.c_str());
+		if (!eventsFile)
 		{
-			cout << "Cannot read a frame from video stream" << endl;
-			break;
+			cout << "Cannot open " << eventsName << endl;
+			return -1;
 		}
+	}
+	ostream* eventsOut = eventsName.empty() ? NULL : &eventsFile;
 
-		// destination frame
-		Mat SkinframeDest;
-		SkinframeDest = Mat::zeros(frame.rows, frame.cols, CV_8UC1); //Returns a zero array of same size as src mat, and of type CV_8UC1
-		//----------------
-		//	b) Skin color detection
-		//----------------
-		mySkinDetect(frame, SkinframeDest);
-		imshow("Skin", SkinframeDest);
-
-		// Convert into binary image using thresholding
-		// Documentation for threshold: http://docs.opencv.org/modules/imgproc/doc/miscellaneous_transformations.html?highlight=threshold#threshold
-		// Example of thresholding: http://docs.opencv.org/doc/tutorials/imgproc/threshold/threshold.html
-		Mat thres_output;
-		threshold(SkinframeDest, thres_output, thresh, max_thresh, 0);
-
-		vector<vector<Point>> contours;
-		vector<Vec4i> hierarchy;
-		// Find contours
-		// Documentation for finding contours: http://docs.opencv.org/modules/imgproc/doc/structural_analysis_and_shape_descriptors.html?highlight=findcontours#findcontours
-		findContours(thres_output, contours, hierarchy, CV_RETR_TREE, CV_CHAIN_APPROX_SIMPLE, Point(0, 0));
-		cout << "The number of contours detected is: " << contours.size() << endl;
-
-		//Mat frameDest = Mat::zeros(thres_output.size(), CV_8UC3);
-		// Find largest contour
-		int maxsize = 0;
-		int maxind = 0;
-		Rect boundrec;
-		for (int i = 0; i < contours.size(); i++)
+	// only a live camera drops frames when the analysis falls behind; files are analysed frame by frame
+	FramePipeline pipeline(source, [&](PipelineFrame& pf) {
+		pf.level = scheduler.plan(FramePipeline::latencyMs(pf));
+		pf.overlay.valid = false;
+		if (pf.level == LEVEL_SKIP)
 		{
-			// Documentation on contourArea: http://docs.opencv.org/modules/imgproc/doc/structural_analysis_and_shape_descriptors.html#
-			double area = contourArea(contours[i]);
-			if (area > maxsize) {
-				maxsize = area;
-				maxind = i;
-				boundrec = boundingRect(contours[i]);
+			pf.hand = HandResult();
+			return;
+		}
+		bool motionRuns = motion && pf.level < LEVEL_NO_MOTION;
+		long long tick = getTickCount();
+		if (motionRuns)
+		{
+			ScopedStageTimer motionTimer(PROFILE_MOTION);
+			background.apply(pf.frame, pf.motion);
+			motionHistory.update(pf.motion);
+			motionHistory.energy(pf.motionEnergy);
+		}
+		long long motionTick = getTickCount();
+		myAnalyzeFrame(pf.frame, pf.skin, scratch, pf.hand);
+		long long analysisTick = getTickCount();
+		if (overlays && pf.level < LEVEL_NO_OVERLAY)
+		{
+			myCaptureOverlay(scratch, pf.overlay);
+		}
+		scheduler.record(pf.level, myTicksToMs(motionTick - tick), myTicksToMs(analysisTick - motionTick), myTicksToMs(getTickCount() - analysisTick));
+		// on the analysis thread, so the event latency does not include the wait for presentation
+		events.update(pf.index, pf.captureTick, pf.hand, pf.frame.size(), motionRuns ? myMotionShare(pf.motionEnergy, pf.hand.bbox) : -1);
+	}, opts.getInt("queue", 4), cap.live());
+	pipeline.start();
+
+	// instead of printing every frame, the counters and the per-stage percentiles are reported every stats_interval=S seconds
+	// (and at the end); stats=FILE also writes them as JSON
+	string statsFile = opts.get("stats");
+	double statsInterval = opts.getDouble("stats_interval", 5);
+	long long lastReport = getTickCount();
+
+	if (headless)
+	{
+		string output = opts.get("output", "gestures.csv");
+		GestureLog log;
+		if (!log.open(output))
+		{
+			cout << "Cannot open " << output << endl;
+			return -1;
+		}
+		long long startTick = getTickCount();
+		unsigned long long frames = 0;
+		PipelineFrame result;
+		while (pipeline.waitResult(result))
+		{
+			// frames skipped under the deadline have no record
+			if (result.level != LEVEL_SKIP)
+			{
+				StageProfiler::record(PROFILE_LATENCY, FramePipeline::latencyMs(result));
+				log.write(result.index, result.hand);
+			}
+			myDrainEvents(events, eventsOut, false);
+			frames++;
+			if (statsInterval > 0 && myTicksToMs(getTickCount() - lastReport) >= statsInterval * 1000)
+			{
+				myReportStats(pipeline, result.allocations, statsFile, scheduler, scratch.gate);
+				lastReport = getTickCount();
 			}
 		}
+		double seconds = myTicksToMs(getTickCount() - startTick) / 1000.0;
+		pipeline.stop();
+		myDrainEvents(events, eventsOut, false);
+		log.close();
+		myReportStats(pipeline, result.allocations, statsFile, scheduler, scratch.gate);
+		cout << frames << " frames in " << seconds << " s (" << (seconds > 0 ? frames / seconds : 0.0) << " fps), written to " << output << endl;
+		return 0;
+	}
 
-		/// Find the convex hull and defect object for each contour
-		vector<vector<Point> >hull(contours.size());
-		vector<vector<Vec4i>>defects(contours.size());
-		vector<vector<int> >inthull(contours.size());
-		for (int i = 0; i < contours.size(); i++)
+	PipelineFrame shown;
+	bool firstShown = false;
+	Mat display;	// the shown frame with its overlays: frames replayed from a recording are read-only
+	while (!pipeline.finished())
+	{
+		if (!pipeline.nextResult(shown))
 		{
-			convexHull(Mat(contours[i]), hull[i], false);
-			convexHull(Mat(contours[i]), inthull[i], false);
-			if (inthull[i].size() > 3) {
-				convexityDefects(contours[i], inthull[i], defects[i]);
+			// nothing new to show yet; keep the windows responsive
+			if (waitKey(1) == 27)
+			{
+				cout << "esc key is pressed by user" << endl;
+				break;
 			}
+			continue;
 		}
 
-		// Draw contours
-		// Documentation for drawing contours: http://docs.opencv.org/modules/imgproc/doc/structural_analysis_and_shape_descriptors.html?highlight=drawcontours#drawcontours
-		// Documentation for drawing rectangle: http://docs.opencv.org/modules/core/doc/drawing_functions.html
-		rectangle(frame, boundrec, Scalar(0, 255, 0), 1, 8, 0);
-		drawContours(frame, hull, maxind, Scalar(0, 0, 255), 2, 8, hierarchy);
-		rectangle(SkinframeDest, boundrec, Scalar(255, 255, 255), 1, 8, 0);
-		drawContours(SkinframeDest, hull, maxind, Scalar(255, 0, 255), 2, 8, hierarchy);
-		//call the condefect function which plot the 
-		condefects(defects[maxind], contours[maxind], frame);
-
-		cout << "The area of the largest contour detected is: " << contourArea(contours[maxind]) << endl;
-		cout << "-----------------------------" << endl << endl;
-
-		/// Show in a window
-		imshow("RockScissorPaper", frame);
-		imshow("source", SkinframeDest);
-		if (waitKey(30) == 27)
+		if (!firstShown)
 		{
-			cout << "esc key is pressed by user" << endl;
-			break;
+			//show the first frame in "MyVideo0" window, before the overlays are drawn on it
+			imshow("MyVideo0", shown.frame);
+			firstShown = true;
 		}
 
-		// //----------------
-		// //	c) Background differencing
-		// //----------------
-
-
-		// //call myFrameDifferencing function
-		// myFrameDifferencing(frame0, frame, frameDest);
-		// imshow("MyVideo", frameDest);
-		// myMotionHistory.erase(myMotionHistory.begin());
-		// myMotionHistory.push_back(frameDest);
-		// Mat myMH = Mat::zeros(frame0.rows, frame0.cols, CV_8UC1);
-
-		// //----------------
-		// //  d) Visualizing motion history
-		// //----------------
-
-		// //call myMotionEnergy function
-		// myMotionEnergy(myMotionHistory, myMH);
+		// a frame skipped under the deadline is not shown: the window keeps the previous one
+		if (shown.level == LEVEL_SKIP)
+		{
+			continue;
+		}
 
+		/// Draw the overlays and show in a window
+		long long renderTick = getTickCount();
+		ScopedStageTimer renderTimer(PROFILE_RENDER);
+		Mat noSkin;
+		Mat view = shown.frame;
+		if (shown.hand.found && shown.overlay.valid)
+		{
+			// copied only when there is something to draw
+			shown.frame.copyTo(display);
+			view = display;
+			myDrawOverlay(view, showSkin ? shown.skin : noSkin, shown.overlay, shown.hand);
+		}
+		// drawing and showing are measured apart: only the drawing is saved by dropping the overlays
+		long long drawnTick = getTickCount();
+		if (showResult)
+		{
+			imshow("RockScissorPaper", view);
+		}
+		if (showSkin)
+		{
+			imshow("Skin", shown.skin);
+		}
+		if (showMotion && shown.level < LEVEL_NO_MOTION)
+		{
+			imshow("MyVideo", shown.motion);
+			imshow("MyVideoMH", shown.motionEnergy);
+		}
+		renderTimer.stop();
+		scheduler.recordRender(shown.level, myTicksToMs(drawnTick - renderTick), myTicksToMs(getTickCount() - drawnTick));
+		myDrainEvents(events, eventsOut, true);
 
-		// imshow("MyVideoMH", myMH); //show the frame in "MyVideo" window
-		// frame0 = frame;
-		// //wait for 'esc' key press for 30ms. If 'esc' key is pressed, break loop
-		// if (waitKey(30) == 27)
-		// {
-		// 	cout << "esc key is pressed by user" << endl;
-		// 	break;
-		// }
+		// the time since the frame was captured
+		StageProfiler::record(PROFILE_LATENCY, FramePipeline::latencyMs(shown));
+		if (statsInterval > 0 && myTicksToMs(getTickCount() - lastReport) >= statsInterval * 1000)
+		{
+			myReportStats(pipeline, shown.allocations, statsFile, scheduler, scratch.gate);
+			lastReport = getTickCount();
+		}
 
+		if (waitKey(1) == 27)
+		{
+			cout << "esc key is pressed by user" << endl;
+			break;
+		}
 	}
+	if (pipeline.finished())
+	{
+		cout << "Cannot read a frame from video stream" << endl;
+	}
+	pipeline.stop();
+	myDrainEvents(events, eventsOut, true);
+	myReportStats(pipeline, shown.allocations, statsFile, scheduler, scratch.gate);
 	waitKey(0);
+	recorder.close();
 	cap.release();
 	return 0;
 }
 
 /** Function Definitions **/
 
-//Function that returns the maximum of 3 integers
-int myMax(int a, int b, int c) {
-	int m = a;
-	(void)((m < b) && (m = b));
-	(void)((m < c) && (m = c));
-	return m;
+//Function that converts a difference of cv::getTickCount() values to milliseconds
+double myTicksToMs(long long ticks) {
+	return ticks * 1000.0 / getTickFrequency();
 }
 
-//Function that returns the minimum of 3 integers
-int myMin(int a, int b, int c) {
-	int m = a;
-	(void)((m > b) && (m = b));
-	(void)((m > c) && (m = c));
-	return m;
+//Function that prints the pipeline counters and the per-stage timing summary
+void myReportStats(const FramePipeline& pipeline, unsigned long long lastAllocations, const string& statsFile, const DeadlineScheduler& scheduler,
+	const SkinGate& gate) {
+	// queue depths at the time of the report
+	PipelineStats stats = pipeline.stats();
+	cout << "Frames " << stats.analysed << "/" << stats.captured << " analysed, capture queue " << stats.captureQueueDepth
+		<< ", present queue " << stats.presentQueueDepth << ", dropped " << stats.droppedCapture + stats.droppedPresent;
+	if (heapAllocationCountingEnabled())
+	{
+		// debug builds: should read 0 once the scratch buffers have grown to their working size
+		cout << ", heap allocations in the last frame " << lastAllocations;
+	}
+	cout << "\n";
+	myReportLevels(scheduler);
+	myReportGate(gate);
+	if (StageProfiler::enabled())
+	{
+		StageProfiler::print(cout);
+	}
+	if (!statsFile.empty() && !StageProfiler::writeJson(statsFile))
+	{
+		cout << "Cannot write " << statsFile << endl;
+	}
+	cout.flush();
 }
 
-//Function that detects whether a pixel belongs to the skin based on RGB values
-void mySkinDetect(Mat& src, Mat& dst) {
-	//Surveys of skin color modeling and detection techniques:
-	//Vezhnevets, Vladimir, Vassili Sazonov, and Alla Andreeva. "A survey on pixel-based skin color detection techniques." Proc. Graphicon. Vol. 3. 2003.
-	//Kakumanu, Praveen, Sokratis Makrogiannis, and Nikolaos Bourbakis. "A survey of skin-color modeling and detection methods." Pattern recognition 40.3 (2007): 1106-1122.
-	for (int i = 0; i < src.rows; i++){
-		for (int j = 0; j < src.cols; j++){
-			//For each pixel, compute the average intensity of the 3 color channels
-			Vec3b intensity = src.at<Vec3b>(i, j); //Vec3b is a vector of 3 uchar (unsigned character)
-			int B = intensity[0]; int G = intensity[1]; int R = intensity[2];
-			if ((R > 95 && G > 40 && B > 20) && (myMax(R, G, B) - myMin(R, G, B) > 15) && (abs(R - G) > 15) && (R > G) && (R > B)){
-				dst.at<uchar>(i, j) = 255;
-			}
+//Function that prints how many frames ran at each level of a frame scheduler
+void myReportLevels(const DeadlineScheduler& scheduler) {
+	if (scheduler.enabled())
+	{
+		cout << "  deadline: " << scheduler.frames(LEVEL_FULL) << " full, " << scheduler.frames(LEVEL_NO_OVERLAY) << " without overlays, "
+			<< scheduler.frames(LEVEL_NO_MOTION) << " without motion, " << scheduler.frames(LEVEL_SKIP) << " skipped\n";
+	}
+}
+
+//Function that prints how many frames the "no hand" gate rejected
+void myReportGate(const SkinGate& gate) {
+	if (gate.enabled())
+	{
+		cout << "  no-hand gate: " << gate.rejected() << " frames rejected\n";
+	}
+}
+
+//Function that reads the next frame of a source and appends it to a raw recording when one is open
+bool myReadAndRecord(FrameInput& input, RawRecorder& recorder, Mat& frame) {
+	if (!input.read(frame))
+	{
+		return false;
+	}
+	// on the capture thread, before the overlays are drawn on the frame
+	if (recorder.isOpen() && !recorder.write(frame))
+	{
+		cout << "Cannot record frame " << recorder.frames() << ", recording stopped" << endl;
+		recorder.close();
+	}
+	return true;
+}
+
+//Function that splits a comma-separated list
+vector<string> mySplitList(const string& list) {
+	vector<string> items;
+	stringstream ss(list);
+	string item;
+	while (getline(ss, item, ','))
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
 		}
 	}
+	return items;
 }
 
-//Function that does frame differencing between the current frame and the previous frame
-void myFrameDifferencing(Mat& prev, Mat& curr, Mat& dst) {
-	//For more information on operation with arrays: http://docs.opencv.org/modules/core/doc/operations_on_arrays.html
-	//For more information on how to use background subtraction methods: http://docs.opencv.org/trunk/doc/tutorials/video/background_subtraction/background_subtraction.html
-	absdiff(prev, curr, dst);
-	Mat gs = dst.clone();
-	cvtColor(dst, gs, CV_BGR2GRAY);
-	dst = gs > 50;
-	Vec3b intensity = dst.at<Vec3b>(100, 100);
+//Function that inserts a stream number before the extension of a file name
+string myStreamFileName(const string& file, size_t stream) {
+	size_t dot = file.find_last_of('.');
+	size_t slash = file.find_last_of("/\\");
+	if (dot == string::npos || (slash != string::npos && dot < slash))
+	{
+		dot = file.size();
+	}
+	stringstream name;
+	name << file.substr(0, dot) << "_" << stream << file.substr(dot);
+	return name.str();
 }
 
-//Function that accumulates the frame differences for a certain number of pairs of frames
-void myMotionEnergy(vector<Mat> mh, Mat& dst) {
-	Mat mh0 = mh[0];
-	Mat mh1 = mh[1];
-	Mat mh2 = mh[2];
+//Function that takes the queued gesture events, writes them to a file and prints them
+void myDrainEvents(GestureStateMachine& machine, ostream* file, bool print) {
+	GestureEvent event;
+	while (machine.nextEvent(event))
+	{
+		if (file)
+		{
+			myWriteEvent(*file, event);
+		}
+		if (print)
+		{
+			cout << "Event " << gestureEventName(event.type) << ": " << gestureName(event.gesture) << " (was " << gestureName(event.previous)
+				<< ") at frame " << event.frame << ", " << event.latencyMs << " ms after capture" << endl;
+		}
+	}
+}
 
-	for (int i = 0; i < dst.rows; i++){
-		for (int j = 0; j < dst.cols; j++){
-			if (mh0.at<uchar>(i, j) == 255 || mh1.at<uchar>(i, j) == 255 || mh2.at<uchar>(i, j) == 255){
-				dst.at<uchar>(i, j) = 255;
+//Function that runs the headless analysis of several streams on a shared work-stealing pool
+int myRunStreams(const Options& opts, const vector<string>& inputs, const HandScratch& scratch,
+	bool motion, const BackgroundModel& background, const MotionHistory& motionHistory, const TemporalConfig& temporal) {
+	// everything a stream keeps from one frame to the next; only the stream's own task touches it
+	struct StreamState {
+		FrameInput input;
+		HandScratch scratch;
+		BackgroundModel background;
+		MotionHistory motionHistory;
+		GestureLog log;
+		GestureStateMachine events;
+		ofstream eventsFile;
+		RawRecorder recorder;
+
+		// skips frames and drops the motion stage of a stream that runs late (deadline=MS)
+		DeadlineScheduler scheduler;
+
+		StreamState(const TemporalConfig& temporal, double deadlineMs, int recoverFrames) : events(temporal), scheduler(deadlineMs, recoverFrames) {}
+	};
+	// output=FILE gets the stream number before its extension: gestures.csv -> gestures_0.csv, gestures_1.csv...
+	// and so do events=FILE and record=FILE
+	string output = opts.get("output", "gestures.csv");
+	string eventsName = opts.get("events");
+	string recordName = opts.get("record");
+	// drop=oldest|newest|none, or one policy per input (comma-separated); by default cameras drop the oldest frame
+	// and files are analysed frame by frame
+	vector<string> drops = mySplitList(opts.get("drop"));
+
+	vector<unique_ptr<StreamState> > states;
+	for (size_t s = 0; s < inputs.size(); s++)
+	{
+		unique_ptr<StreamState> st(new StreamState(temporal, opts.getDouble("deadline", 0), opts.getInt("recover", 8)));
+		if (!st->input.open(inputs[s]))
+		{
+			cout << "Cannot open " << inputs[s] << endl;
+			return -1;
+		}
+		string name = myStreamFileName(output, s);
+		if (!st->log.open(name))
+		{
+			cout << "Cannot open " << name << endl;
+			return -1;
+		}
+		if (!eventsName.empty())
+		{
+			name = myStreamFileName(eventsName, s);
+			st->eventsFile.open(name.c_str());
+			if (!st->eventsFile)
+			{
+				cout << "Cannot open " << name << endl;
+				return -1;
 			}
+			// written from the stream's task as they happen; nobody drains the queue, which keeps only the latest events
+			ostream* out = &st->eventsFile;
+			st->events.setCallback([out](const GestureEvent& e) { myWriteEvent(*out, e); });
+		}
+		if (!recordName.empty() && !st->recorder.open(myStreamFileName(recordName, s)))
+		{
+			cout << "Cannot open " << myStreamFileName(recordName, s) << endl;
+			return -1;
 		}
+		st->scratch = scratch;
+		st->background = background;
+		st->motionHistory = motionHistory;
+		states.push_back(move(st));
 	}
-}
 
-//Function that determines rock, paper, scissors
-void condefects(vector<Vec4i> Defects, vector<Point> contour, Mat &frame)
-{
-	Point2f center;
-	float x;
-	int fingers = 0;
-
-	// find the centorid of the hand 
-	minEnclosingCircle(contour, center, x);
-	circle(frame, center, 10, CV_RGB(0, 0, 255), 2, 8);
-
-	for (int i = 0; i < Defects.size(); i++) {
-
-		//extracting the start point and the depth from the Defects
-		Point ptStart(contour[Defects[i].val[0]]);
-		double depth = static_cast<double>(Defects[i].val[3]) / 256;
-		//display start points
-		circle(frame, ptStart, 5, CV_RGB(255, 0, 0), 2, 8);
-
-		//if the depth > 11 and the start point is higher than the center, count that as a finger
-		if (depth>11 && ptStart.y<center.y) {
-			circle(frame, ptStart, 4, CV_RGB(255, 0, 0), 4);
-			fingers++;
+	// threads=N is the budget of the whole process (0: one per core): a stream never has two frames in analysis, so the
+	// pool gets one thread per stream, up to N, and the rest go to the band executor, which splits the pixel kernels of
+	// whichever stream task finds it free
+	int budget = opts.getInt("threads", 0) > 0 ? opts.getInt("threads", 0) : max(1, (int)thread::hardware_concurrency());
+	int poolThreads = min(budget, (int)states.size());
+	BandExecutor::configureShared(budget - poolThreads + 1, opts.getInt("band", 0));
+	StreamEngine engine([&states, motion](int s, PipelineFrame& pf) {
+		StreamState& st = *states[s];
+		// no overlays without windows: a late frame goes straight to dropping the motion stage
+		pf.level = st.scheduler.plan(FramePipeline::latencyMs(pf));
+		if (pf.level == LEVEL_SKIP)
+		{
+			return;
+		}
+		bool motionRuns = motion && pf.level < LEVEL_NO_MOTION;
+		long long tick = getTickCount();
+		if (motionRuns)
+		{
+			ScopedStageTimer motionTimer(PROFILE_MOTION);
+			st.background.apply(pf.frame, pf.motion);
+			st.motionHistory.update(pf.motion);
+			st.motionHistory.energy(pf.motionEnergy);
+		}
+		long long motionTick = getTickCount();
+		myAnalyzeFrame(pf.frame, pf.skin, st.scratch, pf.hand);
+		st.scheduler.record(pf.level, myTicksToMs(motionTick - tick), myTicksToMs(getTickCount() - motionTick), 0);
+		StageProfiler::record(PROFILE_LATENCY, FramePipeline::latencyMs(pf));
+		st.log.write(pf.index, pf.hand);
+		st.events.update(pf.index, pf.captureTick, pf.hand, pf.frame.size(), motionRuns ? myMotionShare(pf.motionEnergy, pf.hand.bbox) : -1);
+	}, poolThreads);
+	for (size_t s = 0; s < states.size(); s++)
+	{
+		string drop = drops.empty() ? string() : drops[min(s, drops.size() - 1)];
+		DropPolicy policy = states[s]->input.live() ? DROP_OLDEST : DROP_NONE;
+		if (drop == "oldest")
+		{
+			policy = DROP_OLDEST;
+		}
+		else if (drop == "newest")
+		{
+			policy = DROP_NEWEST;
+		}
+		else if (drop == "none")
+		{
+			policy = DROP_NONE;
+		}
+		else if (!drop.empty())
+		{
+			cout << "Unknown drop policy " << drop << " for " << inputs[s] << endl;
 		}
+		StreamState* st = states[s].get();
+		engine.addStream([st](Mat& frame) { return myReadAndRecord(st->input, st->recorder, frame); }, opts.getInt("queue", 4), policy);
 	}
 
-	//index: if number if fingers detected: (0,1):Rock, (2,3):Scussor, (>3):Paper
-	if (fingers >1 && fingers <= 3) {
-		//putText(frame, "Scissor", Point(50, 50), 2, 2, CV_RGB(0, 255, 0), 4, 8);
+	vector<const DeadlineScheduler*> schedulers;
+	vector<const SkinGate*> gates;
+	for (size_t s = 0; s < states.size(); s++)
+	{
+		schedulers.push_back(&states[s]->scheduler);
+		gates.push_back(&states[s]->scratch.gate);
+	}
+	string statsFile = opts.get("stats");
+	double statsInterval = opts.getDouble("stats_interval", 5);
+	long long startTick = getTickCount();
+	engine.start();
+	while (!engine.wait(statsInterval > 0 ? statsInterval * 1000 : -1))
+	{
+		myReportStreamStats(engine, statsFile, schedulers, gates);
 	}
-	else if (fingers <= 1) {
-		//putText(frame, "BLACK POWER", Point(50, 50), 2, 2, CV_RGB(0, 0, 0), 4, 8);
+	double seconds = myTicksToMs(getTickCount() - startTick) / 1000.0;
+	engine.stop();
+	unsigned long long frames = 0;
+	for (size_t s = 0; s < states.size(); s++)
+	{
+		states[s]->log.close();
+		frames += engine.stats((int)s).analysed;
 	}
-	else if (fingers > 3) {
-		//putText(frame, "STOP", Point(50, 50), 2, 2, CV_RGB(255, 0, 0), 4, 8);
+	myReportStreamStats(engine, statsFile, schedulers, gates);
+	cout << frames << " frames from " << states.size() << " streams in " << seconds << " s ("
+		<< (seconds > 0 ? frames / seconds : 0.0) << " fps)" << endl;
+	return 0;
+}
+
+//Function that prints the counters of every stream and the per-stage timing summary
+void myReportStreamStats(const StreamEngine& engine, const string& statsFile, const vector<const DeadlineScheduler*>& schedulers,
+	const vector<const SkinGate*>& gates) {
+	for (int s = 0; s < engine.streams(); s++)
+	{
+		StreamStats stats = engine.stats(s);
+		cout << "Stream " << s << ": frames " << stats.analysed << "/" << stats.captured << " analysed, queue " << stats.queueDepth
+			<< ", dropped " << stats.dropped << "\n";
+		myReportLevels(*schedulers[s]);
+		myReportGate(*gates[s]);
+	}
+	cout << "Tasks stolen between pool threads " << engine.steals() << "\n";
+	if (StageProfiler::enabled())
+	{
+		StageProfiler::print(cout);
+	}
+	if (!statsFile.empty() && !StageProfiler::writeJson(statsFile))
+	{
+		cout << "Cannot write " << statsFile << endl;
 	}
+	cout.flush();
 }
@@ -0,0 +1,205 @@
+#include "StageProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+//Log-linear buckets over microseconds: values below 16 us have a bucket each, then every power of two
+//is split into 16 buckets, so a bucket is never wider than 1/16 of its values. 36 powers reach about 19 hours
+static const int SUB_BITS = 4;
+static const int SUB_BUCKETS = 1 << SUB_BITS;
+static const int BUCKET_COUNT = SUB_BUCKETS + (36 - SUB_BITS) * SUB_BUCKETS;
+
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+	"capture", "motion", "skin", "contours", "hull", "classify", "render", "latency", "event"
+};
+
+const char* StageProfiler::stageName(ProfileStage stage)
+{
+	return stage >= 0 && stage < PROFILE_STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+//Bucket of a duration in microseconds
+static inline int bucketOf(unsigned long long us)
+{
+	if (us < (unsigned long long)SUB_BUCKETS) {
+		return (int)us;
+	}
+	int e = 63;
+	while (!(us >> e)) {
+		e--;
+	}
+	int bucket = SUB_BUCKETS + (e - SUB_BITS) * SUB_BUCKETS + (int)((us >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+	return std::min(bucket, BUCKET_COUNT - 1);
+}
+
+//Middle of a bucket, in microseconds
+static double bucketValue(int bucket)
+{
+	if (bucket < SUB_BUCKETS) {
+		return bucket;
+	}
+	int e = (bucket - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+	int sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+	double width = (double)(1ULL << (e - SUB_BITS));
+	return (SUB_BUCKETS + sub) * width + width / 2;
+}
+
+//Histograms of one thread. Only the owning thread writes (plain load + store, no read-modify-write);
+//summaries read them concurrently, which the atomics make safe
+struct ThreadHistograms {
+	std::atomic<unsigned long long> counts[PROFILE_STAGE_COUNT][BUCKET_COUNT];
+	std::atomic<unsigned long long> totalUs[PROFILE_STAGE_COUNT];
+	std::atomic<unsigned long long> maxUs[PROFILE_STAGE_COUNT];
+
+	ThreadHistograms()
+	{
+		for (int s = 0; s < PROFILE_STAGE_COUNT; s++) {
+			for (int b = 0; b < BUCKET_COUNT; b++) {
+				counts[s][b].store(0, std::memory_order_relaxed);
+			}
+			totalUs[s].store(0, std::memory_order_relaxed);
+			maxUs[s].store(0, std::memory_order_relaxed);
+		}
+	}
+};
+
+//Every thread's histograms, kept until exit so a summary still sees the threads that have finished
+static std::mutex& registryMutex()
+{
+	static std::mutex m;
+	return m;
+}
+
+static std::vector<std::unique_ptr<ThreadHistograms> >& registry()
+{
+	static std::vector<std::unique_ptr<ThreadHistograms> > r;
+	return r;
+}
+
+#ifndef GESTURE_NO_PROFILE
+
+static thread_local ThreadHistograms* t_histograms = 0;
+
+static inline void bump(std::atomic<unsigned long long>& a, unsigned long long v)
+{
+	a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+void StageProfiler::record(ProfileStage stage, double ms)
+{
+	ThreadHistograms* h = t_histograms;
+	if (!h) {
+		//first measurement on this thread: the only time the registry is locked
+		std::lock_guard<std::mutex> lock(registryMutex());
+		registry().push_back(std::unique_ptr<ThreadHistograms>(new ThreadHistograms()));
+		h = t_histograms = registry().back().get();
+	}
+	unsigned long long us = ms > 0 ? (unsigned long long)(ms * 1000.0 + 0.5) : 0;
+	bump(h->counts[stage][bucketOf(us)], 1);
+	bump(h->totalUs[stage], us);
+	if (us > h->maxUs[stage].load(std::memory_order_relaxed)) {
+		h->maxUs[stage].store(us, std::memory_order_relaxed);
+	}
+}
+
+bool StageProfiler::enabled()
+{
+	return true;
+}
+
+#else
+
+bool StageProfiler::enabled()
+{
+	return false;
+}
+
+#endif
+
+//Value below which a fraction q of the measurements fall, in microseconds
+static double percentile(const std::vector<unsigned long long>& counts, unsigned long long total, double q, double maxUs)
+{
+	unsigned long long rank = std::max(1ULL, (unsigned long long)(q * total + 0.999999));
+	unsigned long long seen = 0;
+	for (int b = 0; b < BUCKET_COUNT; b++) {
+		seen += counts[b];
+		if (seen >= rank) {
+			return std::min(bucketValue(b), maxUs);
+		}
+	}
+	return maxUs;
+}
+
+void StageProfiler::summary(std::vector<StageSummary>& out)
+{
+	out.clear();
+	std::lock_guard<std::mutex> lock(registryMutex());
+	std::vector<unsigned long long> counts(BUCKET_COUNT);
+	for (int s = 0; s < PROFILE_STAGE_COUNT; s++) {
+		std::fill(counts.begin(), counts.end(), 0ULL);
+		unsigned long long total = 0, totalUs = 0, maxUs = 0;
+		for (size_t t = 0; t < registry().size(); t++) {
+			const ThreadHistograms& h = *registry()[t];
+			for (int b = 0; b < BUCKET_COUNT; b++) {
+				unsigned long long c = h.counts[s][b].load(std::memory_order_relaxed);
+				counts[b] += c;
+				total += c;
+			}
+			totalUs += h.totalUs[s].load(std::memory_order_relaxed);
+			maxUs = std::max(maxUs, h.maxUs[s].load(std::memory_order_relaxed));
+		}
+		if (total == 0) {
+			continue;
+		}
+		StageSummary sum;
+		sum.name = STAGE_NAMES[s];
+		sum.count = total;
+		sum.mean = totalUs / 1000.0 / total;
+		sum.p50 = percentile(counts, total, 0.50, (double)maxUs) / 1000.0;
+		sum.p95 = percentile(counts, total, 0.95, (double)maxUs) / 1000.0;
+		sum.p99 = percentile(counts, total, 0.99, (double)maxUs) / 1000.0;
+		sum.max = maxUs / 1000.0;
+		out.push_back(sum);
+	}
+}
+
+void StageProfiler::print(std::ostream& os)
+{
+	std::vector<StageSummary> stages;
+	summary(stages);
+	std::ios::fmtflags flags = os.flags();
+	std::streamsize precision = os.precision();
+	os << std::fixed << std::setprecision(3);
+	os << std::left << std::setw(10) << "stage" << std::right << std::setw(10) << "count" << std::setw(10) << "mean"
+		<< std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << " (ms)\n";
+	for (size_t i = 0; i < stages.size(); i++) {
+		const StageSummary& s = stages[i];
+		os << std::left << std::setw(10) << s.name << std::right << std::setw(10) << s.count << std::setw(10) << s.mean
+			<< std::setw(10) << s.p50 << std::setw(10) << s.p95 << std::setw(10) << s.p99 << std::setw(10) << s.max << '\n';
+	}
+	os.flush();
+	os.flags(flags);
+	os.precision(precision);
+}
+
+bool StageProfiler::writeJson(const std::string& path)
+{
+	std::vector<StageSummary> stages;
+	summary(stages);
+	std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+	if (!out.is_open()) {
+		return false;
+	}
+	out << std::fixed << std::setprecision(4) << "{\"stages\":{";
+	for (size_t i = 0; i < stages.size(); i++) {
+		const StageSummary& s = stages[i];
+		out << (i ? "," : "") << "\n  \"" << s.name << "\":{\"count\":" << s.count << ",\"mean_ms\":" << s.mean
+			<< ",\"p50_ms\":" << s.p50 << ",\"p95_ms\":" << s.p95 << ",\"p99_ms\":" << s.p99 << ",\"max_ms\":" << s.max << '}';
+	}
+	out << "\n}}\n";
+	return out.good();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+StageProfiler.h
+
+Hot-path instrumentation: scoped timers on the monotonic clock around each stage of the pipeline, recorded into
+per-thread log-linear histograms. Recording touches only the calling thread's histogram (no lock, no shared
+cache line); summaries merge the histograms of all threads on demand and report count, mean, p50/p95/p99 and max.
+Defining GESTURE_NO_PROFILE compiles the timers and the recording out completely; the per-frame StageTimes
+of HandResult then stay 0.
+*/
+
+/**
+Stages (and the end-to-end latency) that are timed
+*/
+enum ProfileStage {
+	PROFILE_CAPTURE,	// reading a frame from the source
+	PROFILE_MOTION,		// background subtraction and motion history (motion=1)
+	PROFILE_SKIN,		// skin detection
+	PROFILE_CONTOURS,	// blob extraction and the contour of the largest blob
+	PROFILE_HULL,		// convex hull and convexity defects
+	PROFILE_CLASSIFY,	// finger counting and gesture decision
+	PROFILE_RENDER,		// imshow of the result windows
+	PROFILE_LATENCY,	// from capture to presentation of a frame
+	PROFILE_EVENT,		// from capture of a frame to the gesture event it decided (GestureEvents.h)
+	PROFILE_STAGE_COUNT
+};
+
+/**
+Merged statistics of one stage, in milliseconds. Percentiles are accurate to about 6%
+*/
+struct StageSummary {
+	const char* name;
+	unsigned long long count;
+	double mean;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+};
+
+class StageProfiler {
+public:
+	/**
+	Function that returns the lower-case name of a stage
+	@param stage The stage
+	*/
+	static const char* stageName(ProfileStage stage);
+
+	/**
+	Function that tells whether the profiler was compiled in
+	*/
+	static bool enabled();
+
+#ifdef GESTURE_NO_PROFILE
+	static void record(ProfileStage, double) {}
+#else
+	/**
+	Adds one measurement to the calling thread's histogram of a stage
+	@param stage The stage
+	@param ms Duration in milliseconds
+	*/
+	static void record(ProfileStage stage, double ms);
+#endif
+
+	/**
+	Function that merges the histograms of all threads; stages without measurements are left out
+	@param out Receives one entry per measured stage
+	*/
+	static void summary(std::vector<StageSummary>& out);
+
+	/**
+	Writes a human-readable table of the summary
+	@param os The destination stream
+	*/
+	static void print(std::ostream& os);
+
+	/**
+	Function that writes the summary as a JSON object, returns false if the file cannot be written
+	@param path Name of the stats file (overwritten)
+	*/
+	static bool writeJson(const std::string& path);
+};
+
+/**
+Timer that records the time from its construction to stop() (or to its destruction) into a stage histogram
+*/
+class ScopedStageTimer {
+public:
+#ifdef GESTURE_NO_PROFILE
+	explicit ScopedStageTimer(ProfileStage, double* = 0) {}
+	double stop() { return 0; }
+#else
+	/**
+	Starts the timer
+	@param stage The stage the measurement is recorded to
+	@param elapsedMs Optional location that also receives the measured time
+	*/
+	explicit ScopedStageTimer(ProfileStage stage, double* elapsedMs = 0)
+		: m_stage(stage), m_elapsedMs(elapsedMs), m_running(true), m_start(std::chrono::steady_clock::now()) {}
+
+	~ScopedStageTimer() { stop(); }
+
+	/**
+	Function that stops the timer and records the measurement (once), returns the elapsed milliseconds
+	*/
+	double stop()
+	{
+		if (!m_running) {
+			return 0;
+		}
+		m_running = false;
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+		StageProfiler::record(m_stage, ms);
+		if (m_elapsedMs) {
+			*m_elapsedMs = ms;
+		}
+		return ms;
+	}
+
+private:
+	ScopedStageTimer(const ScopedStageTimer&);
+	ScopedStageTimer& operator=(const ScopedStageTimer&);
+
+	ProfileStage m_stage;
+	double* m_elapsedMs;
+	bool m_running;
+	std::chrono::steady_clock::time_point m_start;
+#endif
+};
@@ -0,0 +1,166 @@
+#include "StreamEngine.h"
+
+#include "AllocCounter.h"
+#include "BandExecutor.h"
+#include "StageProfiler.h"
+
+#include <chrono>
+
+//Backs off while a ring is full: a few yields first, then short sleeps
+static void idleWait(int& spins)
+{
+	if (spins < 16) {
+		std::this_thread::yield();
+	}
+	else {
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	spins++;
+}
+
+StreamEngine::StreamEngine(AnalyzeFn analyze, int threads)
+	: m_analyze(analyze), m_stop(false), m_started(false), m_serialKernels(false), m_finished(0), m_pool(threads)
+{
+}
+
+StreamEngine::~StreamEngine()
+{
+	stop();
+}
+
+int StreamEngine::addStream(FramePipeline::FrameSource source, int queueCapacity, DropPolicy policy)
+{
+	m_streams.push_back(std::unique_ptr<Stream>(new Stream(source, queueCapacity, policy)));
+	return (int)m_streams.size() - 1;
+}
+
+void StreamEngine::start()
+{
+	//the per-pixel kernels split their rows over the band executor when it has threads of its own; a task that finds
+	//it busy with another stream runs its bands itself
+	m_serialKernels = BandExecutor::shared().threads() <= 1;
+	m_started = true;
+	for (size_t s = 0; s < m_streams.size(); s++) {
+		m_streams[s]->captureThread = std::thread(&StreamEngine::captureLoop, this, (int)s);
+	}
+}
+
+bool StreamEngine::wait(double timeoutMs)
+{
+	std::unique_lock<std::mutex> lk(m_doneLock);
+	auto allFinished = [this] { return !m_started || m_finished == (int)m_streams.size(); };
+	if (timeoutMs < 0) {
+		m_done.wait(lk, allFinished);
+		return true;
+	}
+	return m_done.wait_for(lk, std::chrono::duration<double, std::milli>(timeoutMs), allFinished);
+}
+
+void StreamEngine::stop()
+{
+	m_stop = true;
+	if (!m_started) {
+		return;
+	}
+	for (size_t s = 0; s < m_streams.size(); s++) {
+		if (m_streams[s]->captureThread.joinable()) {
+			m_streams[s]->captureThread.join();
+		}
+	}
+	//every stream ends once its capture thread is gone: the pending tasks see m_stop and finish it
+	wait();
+}
+
+//Reads the frames of one stream and hands them to its ring
+void StreamEngine::captureLoop(int s)
+{
+	Stream& st = *m_streams[s];
+	PipelineFrame pf;
+	unsigned long long index = 0;
+	while (!m_stop) {
+		ScopedStageTimer captureTimer(PROFILE_CAPTURE);
+		if (!st.source(pf.frame) || pf.frame.empty()) {
+			break;
+		}
+		captureTimer.stop();
+		pf.captureTick = cv::getTickCount();
+		pf.index = index++;
+		st.captured++;
+		if (st.policy == DROP_OLDEST) {
+			st.dropped += st.ring.pushDropOldest(pf);
+		}
+		else if (st.policy == DROP_NEWEST) {
+			if (!st.ring.tryPush(pf)) {
+				st.dropped++;
+				continue;
+			}
+		}
+		else {
+			int spins = 0;
+			while (!st.ring.tryPush(pf) && !m_stop) {
+				idleWait(spins);
+			}
+		}
+		schedule(s);
+	}
+	st.captureDone = true;
+	//one more task, which sees the end of the stream once the ring is empty
+	schedule(s);
+}
+
+void StreamEngine::schedule(int s)
+{
+	//exchange (not compare-exchange) so that a task clearing the flag always sees the frame pushed before it
+	if (!m_streams[s]->scheduled.exchange(true)) {
+		m_pool.submit([this, s] { runStream(s); });
+	}
+}
+
+void StreamEngine::runStream(int s)
+{
+	Stream& st = *m_streams[s];
+	BandExecutor::setSerialOnThisThread(m_serialKernels);
+	if (m_stop || !st.ring.tryPop(st.work)) {
+		st.scheduled.exchange(false);
+		//read captureDone first: once it is set, every frame of the stream is already in the ring
+		bool done = st.captureDone || m_stop;
+		if (st.ring.size() > 0 && !m_stop) {
+			schedule(s);
+		}
+		else if (done) {
+			finish(s);
+		}
+		return;
+	}
+
+	unsigned long long allocationsBefore = heapAllocationsOnThisThread();
+	m_analyze(s, st.work);
+	st.work.allocations = heapAllocationsOnThisThread() - allocationsBefore;
+	st.analysed++;
+
+	//still scheduled: straight to the back of the queue, behind the other streams that are ready
+	m_pool.submit([this, s] { runStream(s); });
+}
+
+void StreamEngine::finish(int s)
+{
+	if (m_streams[s]->finished.exchange(true)) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lk(m_doneLock);
+		m_finished++;
+	}
+	m_done.notify_all();
+}
+
+StreamStats StreamEngine::stats(int stream) const
+{
+	const Stream& st = *m_streams[stream];
+	StreamStats s;
+	s.queueDepth = st.ring.size();
+	s.captured = st.captured;
+	s.analysed = st.analysed;
+	s.dropped = st.dropped;
+	return s;
+}
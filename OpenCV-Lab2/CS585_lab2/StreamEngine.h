@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BoundedRing.h"
+#include "FramePipeline.h"
+#include "WorkStealingPool.h"
+
+/**
+StreamEngine.h
+
+Runs the analysis of many camera or file streams in one process. Every stream has its own capture thread, which
+only reads frames into the stream's ring, and the frames are analysed by tasks on one shared work-stealing pool.
+A stream has at most one frame in analysis at a time, so its state (tracker, background, log...) needs no lock and
+its frames are handled in order; after each frame the stream's task goes to the back of the queue, so ready streams
+take turns on the cores and a fast stream cannot starve the others. What happens when a stream's ring is full is
+chosen per stream.
+*/
+
+/**
+What the capture thread of a stream does when the analysis falls behind and the ring is full
+*/
+enum DropPolicy {
+	DROP_OLDEST,	// evict the oldest queued frame (live cameras: the freshest frame is analysed)
+	DROP_NEWEST,	// discard the frame just read (keeps a contiguous run of older frames)
+	DROP_NONE		// wait until there is room (files: every frame is analysed)
+};
+
+/**
+Snapshot of the counters of one stream
+*/
+struct StreamStats {
+	size_t queueDepth;				// frames waiting for analysis
+	unsigned long long captured;	// frames read from the source
+	unsigned long long analysed;	// frames that went through the analysis
+	unsigned long long dropped;		// frames dropped by the policy
+};
+
+class StreamEngine {
+public:
+	/**
+	Function run on a pool thread for every frame that is not dropped; never called for two frames of the same stream at once
+	@param stream Index of the stream, as returned by addStream
+	@param pf The frame; the analysis results are written into it
+	*/
+	typedef std::function<void(int stream, PipelineFrame& pf)> AnalyzeFn;
+
+	/**
+	Creates the engine and its pool; no thread reads frames yet
+	@param analyze Function that analyses one frame of a stream
+	@param threads Number of pool threads (0 = one per hardware core)
+	*/
+	explicit StreamEngine(AnalyzeFn analyze, int threads = 0);
+
+	/**
+	Stops the streams and joins the threads
+	*/
+	~StreamEngine();
+
+	/**
+	Function that adds a stream, returns its index. Must be called before start()
+	@param source Function that reads the next frame of the stream, returns false at its end. Called only by the stream's capture thread
+	@param queueCapacity Capacity of the stream's ring
+	@param policy What to do with frames when the ring is full
+	*/
+	int addStream(FramePipeline::FrameSource source, int queueCapacity = 4, DropPolicy policy = DROP_OLDEST);
+
+	/**
+	Starts the capture threads
+	*/
+	void start();
+
+	/**
+	Function that waits until every stream has ended and all its frames are analysed (or stop() was called),
+	returns false if that has not happened within the timeout
+	@param timeoutMs Longest time to wait in milliseconds, negative to wait without limit
+	*/
+	bool wait(double timeoutMs = -1);
+
+	/**
+	Asks the streams to stop and waits for the capture threads and the frames in analysis
+	*/
+	void stop();
+
+	/**
+	Function that returns the number of streams
+	*/
+	int streams() const { return (int)m_streams.size(); }
+
+	/**
+	Function that returns the counters of a stream
+	@param stream Index of the stream
+	*/
+	StreamStats stats(int stream) const;
+
+	/**
+	Function that returns the number of tasks the pool threads took from each other's queues
+	*/
+	unsigned long long steals() const { return m_pool.steals(); }
+
+private:
+	StreamEngine(const StreamEngine&);
+	StreamEngine& operator=(const StreamEngine&);
+
+	struct Stream {
+		Stream(FramePipeline::FrameSource source, int queueCapacity, DropPolicy policy)
+			: source(source), policy(policy), ring(queueCapacity), scheduled(false), captureDone(false), finished(false),
+			captured(0), analysed(0), dropped(0) {}
+
+		FramePipeline::FrameSource source;
+		DropPolicy policy;
+		BoundedRing<PipelineFrame> ring;
+		PipelineFrame work;				// frame being analysed; only touched by the stream's current task
+		std::thread captureThread;
+		std::atomic<bool> scheduled;	// a task of the stream is queued or running
+		std::atomic<bool> captureDone;
+		std::atomic<bool> finished;
+		std::atomic<unsigned long long> captured;
+		std::atomic<unsigned long long> analysed;
+		std::atomic<unsigned long long> dropped;
+	};
+
+	void captureLoop(int s);
+	//queues a task for the stream unless one is already queued or running
+	void schedule(int s);
+	//analyses the next frame of the stream, then queues the stream again
+	void runStream(int s);
+	void finish(int s);
+
+	AnalyzeFn m_analyze;
+	std::vector<std::unique_ptr<Stream> > m_streams;
+	std::atomic<bool> m_stop;
+	bool m_started;
+	// kernels run serially on the pool threads when the band executor has no threads besides the caller
+	bool m_serialKernels;
+
+	std::mutex m_doneLock;
+	std::condition_variable m_done;
+	int m_finished;
+
+	// last member: destroyed (and joined) first, while the streams its tasks use still exist
+	WorkStealingPool m_pool;
+};
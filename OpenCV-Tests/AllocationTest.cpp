@@ -0,0 +1,123 @@
+/**
+AllocationTest.cpp
+
+Checks that the hand analysis stops allocating once warmed up: after a few frames, myAnalyzeFrame must not call
+operator new on the analysis thread, on the full frame, in tracking mode and in coarse-to-fine mode. The frames are
+a synthetic hand moving back and forth, so the scratch buffers have seen their largest size before the count starts.
+The test links the always-counting variant of AllocCounter.cpp (alloc_counter_counting), so it counts in every configuration.
+
+Usage: test_allocations
+Returns 0 when no allocation was counted.
+*/
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "BandExecutor.h"
+#include "HandAnalysis.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+Function that draws a synthetic frame: a skin-colored open hand on a noisy background, as in the benchmark
+@param size Frame size
+@param shift Horizontal offset of the hand, in pixels
+@param dst The destination BGR frame
+*/
+void mySyntheticFrame(Size size, int shift, Mat& dst);
+
+/**
+Function that analyses the frames in a loop and counts the allocations after the warm-up, returns true when there were none
+and the hand was found
+@param name Name of the mode, printed with the count
+@param scratch Scratch buffers set up for the mode
+@param frames The frames, analysed in turn
+*/
+bool myCheckMode(const string& name, HandScratch& scratch, const vector<Mat>& frames);
+
+
+int main(int argc, char** argv)
+{
+	if (!heapAllocationCountingEnabled())
+	{
+		cout << "Allocation counting is not compiled in" << endl;
+		return 1;
+	}
+	// several threads, so the bands of the kernels run through the executor and not inline
+	BandExecutor::configureShared(4, 0);
+	// OpenCV's own thread pool allocates a job per parallel call (e.g. in resize); it is not part of the analysis code
+	setNumThreads(0);
+
+	vector<Mat> frames(8);
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		mySyntheticFrame(Size(640, 480), (int)i * 6, frames[i]);
+	}
+
+	bool ok = true;
+	{
+		HandScratch scratch;
+		scratch.draw = false;
+		ok &= myCheckMode("full frame", scratch, frames);
+	}
+	{
+		HandScratch scratch;
+		scratch.draw = false;
+		scratch.tracking = true;
+		scratch.tracker = RoiTracker(5);
+		ok &= myCheckMode("tracking", scratch, frames);
+	}
+	for (int scale = 2; scale <= 4; scale *= 2)
+	{
+		HandScratch scratch;
+		scratch.draw = false;
+		scratch.scaler = ScaleController(0, scale, 4);
+		ok &= myCheckMode("scale " + to_string(scale), scratch, frames);
+	}
+	return ok ? 0 : 1;
+}
+
+//Function that draws a synthetic frame
+void mySyntheticFrame(Size size, int shift, Mat& dst) {
+	dst.create(size, CV_8UC3);
+	RNG rng(0x5eed);
+	rng.fill(dst, RNG::UNIFORM, Scalar(20, 30, 30), Scalar(90, 90, 90));
+	double unit = size.height / 480.0;
+	Scalar skinColor(120, 150, 210);
+	Point palm(size.width / 2 + shift, size.height * 5 / 8);
+	ellipse(dst, palm, Size(cvRound(70 * unit), cvRound(85 * unit)), 0, 0, 360, skinColor, -1);
+	for (int i = 0; i < 5; i++)
+	{
+		double angle = (-60 + 30 * i) * CV_PI / 180;
+		Point tip(palm.x + cvRound(sin(angle) * 170 * unit), palm.y - cvRound(cos(angle) * 170 * unit));
+		line(dst, palm, tip, skinColor, max(1, cvRound(22 * unit)));
+	}
+}
+
+//Function that analyses the frames in a loop and counts the allocations after the warm-up
+bool myCheckMode(const string& name, HandScratch& scratch, const vector<Mat>& frames) {
+	Mat frame, skin;
+	HandResult result;
+	// two rounds over the frames to warm up, then four counted
+	size_t warmup = 2 * frames.size(), counted = 4 * frames.size();
+	unsigned long long before = 0;
+	for (size_t i = 0; i < warmup + counted; i++)
+	{
+		if (i == warmup)
+		{
+			before = heapAllocationsOnThisThread();
+		}
+		// copied into the same buffer every frame, as a capture would
+		frames[i % frames.size()].copyTo(frame);
+		myAnalyzeFrame(frame, skin, scratch, result);
+	}
+	unsigned long long allocations = heapAllocationsOnThisThread() - before;
+	cout << name << ": " << allocations << " allocations in " << counted << " frames" << (result.found ? "" : ", no hand found") << "\n";
+	return allocations == 0 && result.found;
+}
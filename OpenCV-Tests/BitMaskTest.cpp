@@ -0,0 +1,207 @@
+/**
+BitMaskTest.cpp
+
+Checks the word-parallel BitMask operations against a brute-force reference on random masks of every density and of
+widths that are and are not multiples of 64: 3x3 erode and dilate (with the cv::erode / cv::dilate border rules),
+OR and AND, the area of the whole mask and of rectangles partly outside it, and the round trip through a CV_8UC1 Mat.
+The bits past the last column must stay cleared.
+
+Usage: test_bit_mask
+Returns 0 when every result matches.
+*/
+
+#include "opencv2/core/core.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BandExecutor.h"
+#include "BitMask.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+Brute-force copy of a mask: one int per pixel
+*/
+struct ReferenceMask {
+	int rows, cols;
+	vector<int> pixels;
+
+	ReferenceMask(int r, int c) : rows(r), cols(c), pixels(r * c, 0) {}
+	// pixels outside the mask read as border
+	int at(int y, int x, int border) const { return (y < 0 || y >= rows || x < 0 || x >= cols) ? border : pixels[y * cols + x]; }
+};
+
+/**
+Function that fills a mask and its reference with random pixels, returns the reference
+@param rng The random generator
+@param rows Number of rows
+@param cols Number of columns
+@param density Percentage of set pixels
+@param mask Receives the mask
+*/
+ReferenceMask myRandomMask(mt19937& rng, int rows, int cols, int density, BitMask& mask);
+
+/**
+Function that compares a mask with its reference, including the cleared bits past the last column, returns true when they match
+@param mask The mask
+@param expected The reference
+*/
+bool mySameMask(const BitMask& mask, const ReferenceMask& expected);
+
+
+int main(int argc, char** argv)
+{
+	// the operations run in bands; several threads so that the bands are split
+	BandExecutor::configureShared(4, 2);
+	mt19937 rng(13);
+	int failures = 0;
+	for (int t = 0; t < 500; t++)
+	{
+		int rows = 1 + rng() % 24, cols = 1 + rng() % 200;
+		int density = rng() % 101;
+		BitMask a, b;
+		ReferenceMask ra = myRandomMask(rng, rows, cols, density, a);
+		ReferenceMask rb = myRandomMask(rng, rows, cols, rng() % 101, b);
+		string what = to_string(rows) + "x" + to_string(cols) + " mask";
+
+		// 3x3 erode (outside counts as set) and dilate (outside counts as cleared)
+		ReferenceMask eroded(rows, cols), dilated(rows, cols);
+		for (int y = 0; y < rows; y++)
+		{
+			for (int x = 0; x < cols; x++)
+			{
+				int e = 1, d = 0;
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					for (int dx = -1; dx <= 1; dx++)
+					{
+						e &= ra.at(y + dy, x + dx, 1);
+						d |= ra.at(y + dy, x + dx, 0);
+					}
+				}
+				eroded.pixels[y * cols + x] = e;
+				dilated.pixels[y * cols + x] = d;
+			}
+		}
+		BitMask e, d;
+		a.erode(e);
+		a.dilate(d);
+		if (!mySameMask(e, eroded))
+		{
+			cout << "erode differs on a " << what << "\n";
+			failures++;
+		}
+		if (!mySameMask(d, dilated))
+		{
+			cout << "dilate differs on a " << what << "\n";
+			failures++;
+		}
+
+		// OR and AND
+		ReferenceMask ored(rows, cols), anded(rows, cols);
+		for (int i = 0; i < rows * cols; i++)
+		{
+			ored.pixels[i] = ra.pixels[i] | rb.pixels[i];
+			anded.pixels[i] = ra.pixels[i] & rb.pixels[i];
+		}
+		BitMask o = a, n = a;
+		o.orWith(b);
+		n.andWith(b);
+		if (!mySameMask(o, ored) || !mySameMask(n, anded))
+		{
+			cout << "OR/AND differs on a " << what << "\n";
+			failures++;
+		}
+
+		// areas, of the whole mask and of a rectangle that may stick out of it
+		Rect roi((int)(rng() % (cols + 10)) - 5, (int)(rng() % (rows + 4)) - 2, 1 + rng() % (cols + 5), 1 + rng() % (rows + 3));
+		long long total = 0, inside = 0, clipped = 0;
+		for (int y = 0; y < rows; y++)
+		{
+			for (int x = 0; x < cols; x++)
+			{
+				int v = ra.pixels[y * cols + x];
+				total += v;
+				bool in = x >= roi.x && x < roi.x + roi.width && y >= roi.y && y < roi.y + roi.height;
+				inside += in ? v : 0;
+				clipped += in ? 1 : 0;
+			}
+		}
+		if (a.area() != total || a.area(roi) != inside)
+		{
+			cout << "area differs on a " << what << "\n";
+			failures++;
+		}
+		double expectedDensity = clipped > 0 ? (double)inside / clipped : 0;
+		if (fabs(a.density(roi) - expectedDensity) > 1e-9)
+		{
+			cout << "density differs on a " << what << "\n";
+			failures++;
+		}
+
+		// round trip through a CV_8UC1 mask
+		Mat unpacked;
+		a.toMat(unpacked);
+		BitMask packed;
+		packed.fromMat(unpacked);
+		bool bytes = unpacked.rows == rows && unpacked.cols == cols;
+		for (int y = 0; bytes && y < rows; y++)
+		{
+			for (int x = 0; x < cols; x++)
+			{
+				bytes &= unpacked.ptr<uchar>(y)[x] == (ra.pixels[y * cols + x] ? 255 : 0);
+			}
+		}
+		if (!bytes || !mySameMask(packed, ra))
+		{
+			cout << "toMat/fromMat differs on a " << what << "\n";
+			failures++;
+		}
+	}
+	cout << (failures == 0 ? "ok" : "MISMATCH") << endl;
+	return failures == 0 ? 0 : 1;
+}
+
+//Function that fills a mask and its reference with random pixels
+ReferenceMask myRandomMask(mt19937& rng, int rows, int cols, int density, BitMask& mask) {
+	ReferenceMask ref(rows, cols);
+	mask.create(rows, cols);
+	mask.clear();
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < cols; x++)
+		{
+			int v = (int)(rng() % 100) < density;
+			ref.pixels[y * cols + x] = v;
+			mask.set(y, x, v != 0);
+		}
+	}
+	return ref;
+}
+
+//Function that compares a mask with its reference
+bool mySameMask(const BitMask& mask, const ReferenceMask& expected) {
+	if (mask.rows() != expected.rows || mask.cols() != expected.cols)
+	{
+		return false;
+	}
+	for (int y = 0; y < expected.rows; y++)
+	{
+		for (int x = 0; x < expected.cols; x++)
+		{
+			if (mask.get(y, x) != (expected.pixels[y * expected.cols + x] != 0))
+			{
+				return false;
+			}
+		}
+		if (mask.row(y)[mask.wordsPerRow() - 1] & ~mask.lastWordMask())
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,269 @@
+/**
+BlobExtractorTest.cpp
+
+Checks the run-length union-find BlobExtractor against a flood-fill labelling on random masks: sparse and dense noise
+(many small blobs merging through diagonal contacts), filled ellipses, and thin diagonal strokes. The blobs must come
+out in scan order of their first pixel with the flood fill's area, bounding box and start pixel, and the largest blob
+must be the same. The outer contour traced from the largest blob is then expanded back to pixels: it must be a closed
+chain of 8-connected steps that visits exactly the pixels of the blob that touch the background outside it.
+
+Usage: test_blob_extractor
+Returns 0 when every result matches.
+*/
+
+#include "opencv2/core/core.hpp"
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "BlobExtractor.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+Blobs of a mask found by flood fill, in scan order of their first pixel
+*/
+struct ReferenceBlobs {
+	vector<int> labels;		// blob of each pixel, -1 for the background
+	vector<Blob> blobs;
+};
+
+/**
+Function that labels the 8-connected blobs of foreground pixels (value above threshold) with a flood fill
+@param mask The CV_8UC1 mask
+@param threshold Foreground threshold
+*/
+ReferenceBlobs myFloodFillBlobs(const Mat& mask, int threshold);
+
+/**
+Function that returns the pixels of a blob that have a 4-neighbour in the background outside the blob (the background
+4-connected to the border of the image; pixels beyond the border count as outside)
+@param mask The CV_8UC1 mask
+@param threshold Foreground threshold
+@param ref The flood fill labelling
+@param blob The blob
+*/
+set<pair<int, int> > myOuterBoundary(const Mat& mask, int threshold, const ReferenceBlobs& ref, int blob);
+
+/**
+Function that checks a traced contour, returns an empty string when it is right or what is wrong
+@param contour The traced points, with the offset removed
+@param boundary The pixels the trace must visit
+*/
+string myCheckContour(const vector<Point>& contour, const set<pair<int, int> >& boundary);
+
+
+int main(int argc, char** argv)
+{
+	mt19937 rng(14);
+	const int threshold = 128;
+	int failures = 0;
+	BlobExtractor extractor;
+	for (int t = 0; t < 2000; t++)
+	{
+		int rows = 1 + rng() % 40, cols = 1 + rng() % 90;
+		int kind = t % 4;
+		Mat mask(rows, cols, CV_8UC1);
+		for (int y = 0; y < rows; y++)
+		{
+			for (int x = 0; x < cols; x++)
+			{
+				bool v;
+				if (kind == 0 || kind == 1)
+				{
+					// noise, sparse or dense
+					v = (int)(rng() % 100) < (kind == 0 ? 45 : 70);
+				}
+				else if (kind == 2)
+				{
+					double cx = cols / 2.0, cy = rows / 2.0, rx = cols / 3.0 + 1, ry = rows / 3.0 + 1;
+					v = (x - cx) * (x - cx) / (rx * rx) + (y - cy) * (y - cy) / (ry * ry) <= 1;
+				}
+				else
+				{
+					// one-pixel diagonal strokes, joined only through corners, plus some noise
+					v = (x + y) % 7 == 0 || (x - y + 100) % 11 == 0 || rng() % 100 < 5;
+				}
+				// foreground and background values on both sides of the threshold
+				mask.ptr<uchar>(y)[x] = v ? (rng() % 2 ? 255 : 200) : (rng() % 4 == 0 ? 100 : 0);
+			}
+		}
+		string what = "mask " + to_string(t) + " (" + to_string(rows) + "x" + to_string(cols) + ")";
+
+		ReferenceBlobs ref = myFloodFillBlobs(mask, threshold);
+		int largest = extractor.extract(mask, threshold, 1);
+		const vector<Blob>& blobs = extractor.blobs();
+		bool same = blobs.size() == ref.blobs.size();
+		for (size_t i = 0; same && i < blobs.size(); i++)
+		{
+			same = blobs[i].area == ref.blobs[i].area && blobs[i].bbox == ref.blobs[i].bbox && blobs[i].start == ref.blobs[i].start;
+		}
+		if (!same)
+		{
+			cout << "blobs differ from the flood fill on " << what << "\n";
+			failures++;
+			continue;
+		}
+		int expected = -1;
+		for (size_t i = 0; i < ref.blobs.size(); i++)
+		{
+			if (expected < 0 || ref.blobs[i].area > ref.blobs[expected].area)
+			{
+				expected = (int)i;
+			}
+		}
+		if (largest != expected)
+		{
+			cout << "largest blob " << largest << " instead of " << expected << " on " << what << "\n";
+			failures++;
+			continue;
+		}
+		if (largest < 0)
+		{
+			continue;
+		}
+
+		// the offset is added to every point
+		vector<Point> contour;
+		extractor.traceOuterContour(mask, largest, contour, Point(3, 4));
+		for (size_t i = 0; i < contour.size(); i++)
+		{
+			contour[i] = contour[i] - Point(3, 4);
+		}
+		string error = myCheckContour(contour, myOuterBoundary(mask, threshold, ref, largest));
+		if (!error.empty())
+		{
+			cout << "contour of the largest blob: " << error << " on " << what << "\n";
+			failures++;
+		}
+	}
+	cout << (failures == 0 ? "ok" : "MISMATCH") << endl;
+	return failures == 0 ? 0 : 1;
+}
+
+//Function that labels the 8-connected blobs of foreground pixels with a flood fill
+ReferenceBlobs myFloodFillBlobs(const Mat& mask, int threshold) {
+	ReferenceBlobs ref;
+	ref.labels.assign(mask.rows * mask.cols, -1);
+	vector<Point> stack;
+	for (int y = 0; y < mask.rows; y++)
+	{
+		for (int x = 0; x < mask.cols; x++)
+		{
+			if (mask.ptr<uchar>(y)[x] <= threshold || ref.labels[y * mask.cols + x] >= 0)
+			{
+				continue;
+			}
+			int id = (int)ref.blobs.size();
+			Blob b;
+			b.area = 0;
+			b.start = Point(x, y);
+			int x0 = x, y0 = y, x1 = x, y1 = y;
+			ref.labels[y * mask.cols + x] = id;
+			stack.push_back(Point(x, y));
+			while (!stack.empty())
+			{
+				Point p = stack.back();
+				stack.pop_back();
+				b.area++;
+				x0 = min(x0, p.x); y0 = min(y0, p.y); x1 = max(x1, p.x); y1 = max(y1, p.y);
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					for (int dx = -1; dx <= 1; dx++)
+					{
+						int nx = p.x + dx, ny = p.y + dy;
+						if (nx >= 0 && ny >= 0 && nx < mask.cols && ny < mask.rows && mask.ptr<uchar>(ny)[nx] > threshold && ref.labels[ny * mask.cols + nx] < 0)
+						{
+							ref.labels[ny * mask.cols + nx] = id;
+							stack.push_back(Point(nx, ny));
+						}
+					}
+				}
+			}
+			b.bbox = Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+			ref.blobs.push_back(b);
+		}
+	}
+	return ref;
+}
+
+//Function that returns the pixels of a blob that have a 4-neighbour in the background outside the blob
+set<pair<int, int> > myOuterBoundary(const Mat& mask, int threshold, const ReferenceBlobs& ref, int blob) {
+	// everything that is not the blob, 4-connected to a one pixel frame around the image, is outside
+	int w = mask.cols + 2, h = mask.rows + 2;
+	vector<char> outside(w * h, 0);
+	vector<Point> stack(1, Point(0, 0));
+	outside[0] = 1;
+	while (!stack.empty())
+	{
+		Point p = stack.back();
+		stack.pop_back();
+		const int DX[4] = { 1, -1, 0, 0 }, DY[4] = { 0, 0, 1, -1 };
+		for (int k = 0; k < 4; k++)
+		{
+			int nx = p.x + DX[k], ny = p.y + DY[k];
+			if (nx < 0 || ny < 0 || nx >= w || ny >= h || outside[ny * w + nx])
+			{
+				continue;
+			}
+			bool inImage = nx >= 1 && ny >= 1 && nx <= mask.cols && ny <= mask.rows;
+			if (inImage && ref.labels[(ny - 1) * mask.cols + nx - 1] == blob)
+			{
+				continue;
+			}
+			outside[ny * w + nx] = 1;
+			stack.push_back(Point(nx, ny));
+		}
+	}
+	set<pair<int, int> > boundary;
+	for (int y = 0; y < mask.rows; y++)
+	{
+		for (int x = 0; x < mask.cols; x++)
+		{
+			if (ref.labels[y * mask.cols + x] != blob)
+			{
+				continue;
+			}
+			int px = x + 1, py = y + 1;
+			if (outside[py * w + px - 1] || outside[py * w + px + 1] || outside[(py - 1) * w + px] || outside[(py + 1) * w + px])
+			{
+				boundary.insert(make_pair(x, y));
+			}
+		}
+	}
+	return boundary;
+}
+
+//Function that checks a traced contour
+string myCheckContour(const vector<Point>& contour, const set<pair<int, int> >& boundary) {
+	if (contour.empty())
+	{
+		return "empty";
+	}
+	// CHAIN_APPROX_SIMPLE keeps the corners only: walk the straight segments between them, closing the loop
+	set<pair<int, int> > visited;
+	for (size_t i = 0; i < contour.size(); i++)
+	{
+		Point a = contour[i], b = contour[(i + 1) % contour.size()];
+		int dx = b.x - a.x, dy = b.y - a.y;
+		if (dx != 0 && dy != 0 && abs(dx) != abs(dy))
+		{
+			return "a segment is not horizontal, vertical or diagonal";
+		}
+		int steps = max(abs(dx), abs(dy));
+		Point step((dx > 0) - (dx < 0), (dy > 0) - (dy < 0));
+		for (int k = 0; k <= steps; k++)
+		{
+			visited.insert(make_pair(a.x + k * step.x, a.y + k * step.y));
+		}
+	}
+	if (visited != boundary)
+	{
+		return "visits " + to_string(visited.size()) + " pixels instead of the " + to_string(boundary.size()) + " outer boundary pixels";
+	}
+	return string();
+}
@@ -0,0 +1,149 @@
+/**
+SkinDetectTest.cpp
+
+Checks that every skin detection row kernel the running CPU supports (AVX2, SSSE3 and scalar, with byte and bit-packed
+masks) gives exactly the mask of the original per-pixel rule written with myMax and myMin. The rows are random, biased
+towards the thresholds of the rule, and of every width from 0 to 300 pixels so that each SIMD tail length is covered;
+then every row of a real photo is checked.
+
+Usage: test_skin_detect [IMAGE]
+Returns 0 when every mask matches.
+*/
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include <iostream>
+#include <random>
+#include <stdlib.h>
+#include <vector>
+
+#include "ImageKernels.h"
+#include "SkinDetect.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+Function that classifies one row with the rule of the original mySkinDetect
+@param bgr Pointer to the first pixel of the row
+@param mask Receives 255 for the skin pixels and 0 for the others
+@param width Number of pixels in the row
+*/
+void myReferenceRow(const uchar* bgr, uchar* mask, int width);
+
+/**
+Function that runs every kernel on one row and compares their masks with the reference, returns the number of kernels that differ
+@param bgr Pointer to the first pixel of the row
+@param width Number of pixels in the row
+@param what Description of the row printed with a mismatch
+*/
+int myCheckRow(const uchar* bgr, int width, const string& what);
+
+static const char* const KERNELS[] = { "avx2", "ssse3", "scalar" };
+
+
+int main(int argc, char** argv)
+{
+	cout << "Kernel picked at startup: " << skinDetectKernelName() << "\n";
+	for (const char* kernel : KERNELS)
+	{
+		vector<uchar> px(3), mask(1);
+		if (!skinDetectRowWith(kernel, px.data(), mask.data(), 1))
+		{
+			cout << kernel << " is not supported by this CPU, skipped\n";
+		}
+	}
+
+	// random rows: half of the pixels uniform, half close to the thresholds (R 95, G 40, B 20, R - G 15, R = B)
+	mt19937 rng(585);
+	uniform_int_distribution<int> any(0, 255), near(-20, 20);
+	int failures = 0;
+	for (int round = 0; round < 20; round++)
+	{
+		for (int width = 0; width <= 300; width++)
+		{
+			// exactly 3 * width bytes, so that a kernel reading past the row is caught by the sanitizers
+			vector<uchar> px(3 * width);
+			for (int j = 0; j < width; j++)
+			{
+				uchar* p = &px[3 * j];
+				if (any(rng) & 1)
+				{
+					p[0] = (uchar)any(rng); p[1] = (uchar)any(rng); p[2] = (uchar)any(rng);
+				}
+				else
+				{
+					int R = 95 + near(rng) + (any(rng) & 64);
+					p[2] = saturate_cast<uchar>(R);
+					p[1] = saturate_cast<uchar>((any(rng) & 1) ? 40 + near(rng) : R - 15 + near(rng));
+					p[0] = saturate_cast<uchar>((any(rng) & 1) ? 20 + near(rng) : R + near(rng));
+				}
+			}
+			failures += myCheckRow(px.data(), width, "random row of width " + to_string(width));
+		}
+	}
+	cout << "Random rows: " << (failures == 0 ? "ok" : "MISMATCH") << "\n";
+
+	if (argc > 1)
+	{
+		Mat image = imread(argv[1], IMREAD_COLOR);
+		if (image.empty())
+		{
+			cout << "Cannot read " << argv[1] << endl;
+			return 1;
+		}
+		int before = failures;
+		for (int i = 0; i < image.rows; i++)
+		{
+			failures += myCheckRow(image.ptr<uchar>(i), image.cols, string(argv[1]) + " row " + to_string(i));
+		}
+		cout << "Rows of " << argv[1] << " (" << image.cols << "x" << image.rows << "): " << (failures == before ? "ok" : "MISMATCH") << "\n";
+	}
+	return failures == 0 ? 0 : 1;
+}
+
+//Function that classifies one row with the rule of the original mySkinDetect
+void myReferenceRow(const uchar* bgr, uchar* mask, int width) {
+	for (int j = 0; j < width; j++)
+	{
+		int B = bgr[3 * j]; int G = bgr[3 * j + 1]; int R = bgr[3 * j + 2];
+		bool skin = (R > 95 && G > 40 && B > 20) && (myMax(R, G, B) - myMin(R, G, B) > 15) && (abs(R - G) > 15) && (R > G) && (R > B);
+		mask[j] = skin ? 255 : 0;
+	}
+}
+
+//Function that runs every kernel on one row and compares their masks with the reference
+int myCheckRow(const uchar* bgr, int width, const string& what) {
+	vector<uchar> expected(width), mask(width);
+	myReferenceRow(bgr, expected.data(), width);
+	int words = (width + 63) / 64;
+	int failures = 0;
+	for (const char* kernel : KERNELS)
+	{
+		fill(mask.begin(), mask.end(), (uchar)123);
+		if (!skinDetectRowWith(kernel, bgr, mask.data(), width))
+		{
+			continue;
+		}
+		if (mask != expected)
+		{
+			cout << kernel << ": byte mask differs on " << what << "\n";
+			failures++;
+		}
+		// the bits past the width must be cleared
+		vector<unsigned long long> bits(words, ~0ULL);
+		skinDetectRowBitsWith(kernel, bgr, bits.data(), width);
+		for (int j = 0; j < words * 64; j++)
+		{
+			bool bit = ((bits[j >> 6] >> (j & 63)) & 1) != 0;
+			if (bit != (j < width && expected[j] != 0))
+			{
+				cout << kernel << ": bit mask differs at pixel " << j << " on " << what << "\n";
+				failures++;
+				break;
+			}
+		}
+	}
+	return failures;
+}
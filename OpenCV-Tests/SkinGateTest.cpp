@@ -0,0 +1,170 @@
+/**
+SkinGateTest.cpp
+
+Checks the "no hand" gate against a brute-force search on random masks: sparse noise, dense noise, single
+rectangles and 8x8 blocks of whole pixel counts, whose densities fall right on the threshold, of sizes that are and are not multiples of the 8-pixel blocks, at working scales 1, 2 and 4. The reference
+counts the skin pixels of every block-aligned square pixel by pixel, instead of through the per-row block counts and
+the summed-area table. The rejected-frame counter must count the masks without a candidate, and survive a copy.
+
+Usage: test_skin_gate
+Returns 0 when every result matches.
+*/
+
+#include "opencv2/core/core.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "SkinGate.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+Function that returns true if some block-aligned square of a mask is dense enough, by counting its pixels one by one
+@param mask The mask, 255 for skin and 0 elsewhere, rows * cols bytes
+@param rows Number of rows
+@param cols Number of columns
+@param size Side of the square in pixels at full scale (0: always true)
+@param density Share of skin pixels the square needs
+@param scale Working scale of the mask
+*/
+bool myBruteForceCandidate(const vector<unsigned char>& mask, int rows, int cols, int size, double density, int scale);
+
+
+int main(int argc, char** argv)
+{
+	mt19937 rng(17);
+	int failures = 0;
+	int candidates = 0;
+	unsigned long long rejections = 0;
+	SkinGate counted(32, 0.5);
+	for (int t = 0; t < 3000; t++)
+	{
+		int rows = 1 + rng() % 70, cols = 1 + rng() % 90;
+		int size = rng() % 48;
+		double density = 0.05 + 0.95 * (rng() % 100) / 100.0;
+		int scale = 1 << (rng() % 3);
+
+		// sparse noise, dense noise, one rectangle of skin, or 8x8 blocks of up to k pixels for a density of k/64
+		vector<unsigned char> mask(rows * cols, 0);
+		int kind = rng() % 4;
+		for (int i = 0; i < rows * cols && kind < 2; i++)
+		{
+			mask[i] = (kind == 0 ? rng() % 50 == 0 : rng() % 2 == 0) ? 255 : 0;
+		}
+		if (kind == 2)
+		{
+			int x0 = rng() % cols, y0 = rng() % rows, w = 1 + rng() % 30, h = 1 + rng() % 30;
+			for (int y = y0; y < min(rows, y0 + h); y++)
+			{
+				for (int x = x0; x < min(cols, x0 + w); x++)
+				{
+					mask[y * cols + x] = 255;
+				}
+			}
+		}
+		if (kind == 3)
+		{
+			density = (1 + rng() % 64) / 64.0;
+			for (int by = 0; by < rows; by += 8)
+			{
+				for (int bx = 0; bx < cols; bx += 8)
+				{
+					int k = rng() % 65;
+					for (int i = 0; i < 64 && k > 0; i++)
+					{
+						int y = by + i / 8, x = bx + i % 8;
+						if (y < rows && x < cols && rng() % 64 < (unsigned)k)
+						{
+							mask[y * cols + x] = 255;
+							k--;
+						}
+					}
+				}
+			}
+		}
+
+		// rows are independent: count them in any order
+		SkinGate gate(size, density);
+		gate.reset(Size(cols, rows));
+		vector<int> order(rows);
+		for (int y = 0; y < rows; y++)
+		{
+			order[y] = y;
+		}
+		shuffle(order.begin(), order.end(), rng);
+		for (int y : order)
+		{
+			gate.countRow(y, &mask[y * cols]);
+		}
+		bool expected = myBruteForceCandidate(mask, rows, cols, size, density, scale);
+		if (gate.anyCandidate(scale) != expected)
+		{
+			cout << "candidate differs on a " << rows << "x" << cols << " mask (size " << size << ", density " << density
+				<< ", scale " << scale << "): expected " << expected << "\n";
+			failures++;
+		}
+		if (gate.rejected() != (expected || !gate.enabled() ? 0u : 1u))
+		{
+			cout << "rejected count " << gate.rejected() << " on a " << rows << "x" << cols << " mask\n";
+			failures++;
+		}
+		candidates += expected;
+
+		// one gate over many frames, as in the analysis
+		counted.reset(Size(cols, rows));
+		for (int y = 0; y < rows; y++)
+		{
+			counted.countRow(y, &mask[y * cols]);
+		}
+		rejections += counted.anyCandidate(scale) ? 0 : 1;
+	}
+	SkinGate copy(counted);
+	SkinGate assigned;
+	assigned = counted;
+	if (counted.rejected() != rejections || copy.rejected() != rejections || assigned.rejected() != rejections)
+	{
+		cout << "rejected count " << counted.rejected() << " (copies " << copy.rejected() << ", " << assigned.rejected()
+			<< ") after " << rejections << " rejections\n";
+		failures++;
+	}
+	cout << "3000 masks, " << candidates << " with a candidate, " << failures << " failures" << endl;
+	return failures == 0 ? 0 : 1;
+}
+
+//Function that returns true if some block-aligned square of a mask is dense enough
+bool myBruteForceCandidate(const vector<unsigned char>& mask, int rows, int cols, int size, double density, int scale) {
+	if (size == 0)
+	{
+		return true;
+	}
+	// the square in whole 8x8 blocks, at least one, and no larger than the mask
+	const int block = 8;
+	int blockRows = (rows + block - 1) / block, blockCols = (cols + block - 1) / block;
+	int side = max(1, size / scale / block);
+	int wx = min(side, blockCols), wy = min(side, blockRows);
+	for (int by = 0; by + wy <= blockRows; by++)
+	{
+		for (int bx = 0; bx + wx <= blockCols; bx++)
+		{
+			int x0 = bx * block, y0 = by * block;
+			int x1 = min(cols, (bx + wx) * block), y1 = min(rows, (by + wy) * block);
+			int skin = 0;
+			for (int y = y0; y < y1; y++)
+			{
+				for (int x = x0; x < x1; x++)
+				{
+					skin += mask[y * cols + x] != 0;
+				}
+			}
+			if (skin > 0 && skin >= density * (x1 - x0) * (y1 - y0))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}